@@ -3,6 +3,7 @@
 
 #define MAIN "RMB"
 // #define BUILD_DEBUG
+// #define BUILD_TRACE // input latency tracer, see src/Utils/Tracer.h
 #define MAX_PROCESS 5
 #define EXTERNALS_DIR "externals"
 #ifdef BUILD_DEBUG
@@ -293,6 +293,9 @@ void default_platform_specific_compile_options(Nob_Cmd* cmd, CompileObjsOptions*
     nob_cmd_append(cmd, "-Od", "-EHsc", "-Zi", "-Ob0", "-MDd", "-RTC1", "-D_DEBUG=1");
 #else
     nob_cmd_append(cmd, "-O2", "-Ob2", "-MD", "-DNDEBUG");
+#endif
+#ifdef BUILD_TRACE
+    nob_cmd_append(cmd, "-DRMB_TRACE=1");
 #endif
     // such bloat....
     nob_cmd_append(cmd, "-WX-", "-D_UNICODE", "-DUNICODE", "-DWIN32", "-D_WINDOWS", "-Gm-", "-GS",
@@ -316,6 +319,9 @@ void default_platform_specific_compile_options(Nob_Cmd* cmd, CompileObjsOptions*
 #else
     nob_cmd_append(cmd, "-O2", "-DNDEBUG");
 #endif // BUILD_DEBUG
+#ifdef BUILD_TRACE
+    nob_cmd_append(cmd, "-DRMB_TRACE=1");
+#endif
 
 #if defined(__APPLE__) || defined(__MACH__)
 #else  // MACOS
@@ -1083,6 +1089,69 @@ defer:
     return result;
 }
 
+#if !defined(_WIN32) && !defined(__APPLE__) && !defined(__MACH__)
+// Headless pipeline simulation (`src/sim`), runs without X11, GLFW or ImGui. Built by `nob sim`.
+int build_sim() {
+    static const char* build_path = BUILD__PATH("RMB-sim");
+    static const char* core_sources[] = {
+        "src/mouse.cpp",        "src/npad_controller.cpp", "src/keyboard_manager.cpp",
+        "src/key_scheduler.cpp", "src/Config.cpp",         "src/Utils/Utils.cpp",
+        "src/Utils/Tracer.cpp",  "src/input_trace.cpp",     "src/thread_priority.cpp",
+        "src/mouse_filter.cpp",   "src/response_curve.cpp"};
+    const char* sim_path = nob_temp_sprintf("%s/" MAIN "-sim" BUILD_OUT_SUFFIX, build_path);
+
+    if (!nob_mkdir_recursively_if_not_exists(build_path)) {
+        return 0;
+    }
+
+    int result = 1;
+
+    Nob_Cmd cmd = {0};
+    Nob_File_Paths srcs = {0};
+    Nob_File_Paths object_files = {0};
+
+    nob_da_append_many(&srcs, core_sources, NOB_ARRAY_LEN(core_sources));
+    if (!nob_find_files_with_extensions("src/sim", source_exts, NOB_ARRAY_LEN(source_exts),
+                                        &srcs)) {
+        nob_return_defer(0);
+    }
+
+    nob_cmd_append(&cmd, cpp_compiler_exec);
+    CompileObjsOptions compile_objs_options = {.input_dir = "src", .build_dir = build_path};
+    default_platform_specific_compile_options(&cmd, &compile_objs_options);
+    compile_objs_options.force_rebuild = true;
+    nob_cmd_append(&cmd, "-Wno-class-memaccess", "-Wall", "-std=c++20");
+    nob_cmd_append(&cmd, "-Isrc", "-Isrc/Utils", "-Isrc/sim");
+    for (size_t i = 0; i < NOB_ARRAY_LEN(externals); i++) {
+        const char* dir = default_external_dir(&externals[i]);
+        nob_cmd_append(&cmd, nob_temp_sprintf("-I%s", dir), nob_temp_sprintf("-I%s/include", dir));
+    }
+
+    if (!compile_obj_files(&cmd, &compile_objs_options, srcs.items, srcs.count, &object_files)) {
+        nob_return_defer(0);
+    }
+
+    cmd.count = 0;
+    if (nob_needs_rebuild(sim_path, object_files.items, object_files.count)) {
+        nob_cmd_append(&cmd, cpp_compiler_exec, "-o", sim_path);
+        for (size_t i = 0; i < object_files.count; ++i) {
+            nob_cmd_append(&cmd, object_files.items[i]);
+        }
+        nob_cmd_append(&cmd, "-lm", "-lpthread");
+        if (!nob_cmd_run_sync(cmd))
+            nob_return_defer(false);
+    }
+    nob_log(NOB_INFO, "Built '" MAIN "-sim' successfully: %s", sim_path);
+
+defer:
+    nob_cmd_free(cmd);
+    nob_da_free(srcs);
+    nob_da_free(object_files);
+    nob_temp_reset();
+    return result;
+}
+#endif // LINUX
+
 void cleanup() {
     nob_log(NOB_INFO, "Finished '" MAIN "' building step, cleaning up and quitting.");
 #ifndef _WIN32
@@ -1118,6 +1187,17 @@ int main(int argc, char** argv) {
     if (!build_main())
         nob_return_defer(1);
 
+    if (argc > 0 && strcmp(argv[0], "sim") == 0) {
+#if !defined(_WIN32) && !defined(__APPLE__) && !defined(__MACH__)
+        nob_log(NOB_INFO, "BUILDING '" MAIN "-sim'");
+        if (!build_sim())
+            nob_return_defer(1);
+#else
+        nob_log(NOB_ERROR, "'" MAIN "-sim' is only supported on Linux for now");
+        nob_return_defer(1);
+#endif
+    }
+
 defer:
     cleanup();
     return result;
@@ -19,15 +19,30 @@
 #endif
 
 #include "Config.h"
+#include "Tracer.h"
 #include "Utils.h"
+#include "input_trace.h"
+#include "key_scheduler.h"
+#include "keyboard_manager.h"
 #include "mouse.h"
 #include "npad_controller.h"
+#include "thread_priority.h"
 #include "views/MainView.h"
 
 #include <thread>
 #include <chrono>
 #include <stdio.h>
 
+#if defined(__linux__)
+#include "linux_config_watcher.h"
+#include "linux_event_loop.h"
+#endif
+
+#ifndef _WIN32
+#include <pthread.h>
+#include <signal.h>
+#endif
+
 static int screen_center_x_ = 0;
 static int screen_center_y_ = 0;
 
@@ -54,23 +69,38 @@ Application::Application() {
 }
 
 Application::~Application() {
+#if defined(__linux__)
+    /* the main view saves the config on the way out, nothing should react to that anymore */
+    delete config_watcher_;
+    config_watcher_ = nullptr;
+#endif
     is_running_ = false;
     panning_started_ = false;
-    ImGui_ImplOpenGL3_Shutdown();
-    ImGui_ImplGlfw_Shutdown();
-    ImGui::DestroyContext();
-
-    glfwDestroyWindow(main_window_);
-    glfwTerminate();
+    EventBus::Instance().stop_dispatcher();
+    RMB_TRACE_REPORT();
+    RMB_TRACE_SHUTDOWN();
+    if (!headless_) {
+        ImGui_ImplOpenGL3_Shutdown();
+        ImGui_ImplGlfw_Shutdown();
+        ImGui::DestroyContext();
+
+        glfwDestroyWindow(main_window_);
+        glfwTerminate();
+    }
 
-    delete controller_;
+    /* the mouse feeds the controller, stop it first */
     delete mouse_;
+    delete controller_;
     delete main_view_;
+#if defined(__linux__)
+    delete event_loop_;
+#endif
 
     main_window_ = nullptr;
     controller_ = nullptr;
     mouse_ = nullptr;
     main_view_ = nullptr;
+    event_loop_ = nullptr;
 
     instance_ = nullptr;
 }
@@ -88,9 +118,6 @@ bool Application::Initialize(const char* name, uint32_t width, uint32_t height)
     if (!glfwInit())
         return false;
 
-    EventBus::Instance().subscribe(&Application::OnHotkey);
-    EventBus::Instance().subscribe(&Application::OnMouseButton);
-
 #if defined(IMGUI_IMPL_OPENGL_ES2)
     // GL ES 2.0 + GLSL 100
     const char* glsl_version = "#version 100";
@@ -118,47 +145,95 @@ bool Application::Initialize(const char* name, uint32_t width, uint32_t height)
     if (main_window_ == nullptr)
         return false;
 
-    controller_ = new NpadController();
-    mouse_ = new Mouse();
+    InitializePipeline(nullptr);
+    WatchConfig();
 
     glfwMakeContextCurrent(main_window_);
     glfwSwapInterval(1);
     glfwSetKeyCallback(main_window_, OnKeyCallback);
 
-    Reconfig();
-#if _DEBUG
-    Native::GetInstance()->RegisterHotKey(glfwGetKeyScancode(GLFW_KEY_T),
-                                          glfwGetKeyScancode(GLFW_KEY_LEFT_CONTROL));
-#endif
-
     IMGUI_CHECKVERSION();
     ImGui::CreateContext();
     main_view_ = new MainView();
     return ImGui_ImplGlfw_InitForOpenGL(main_window_, true) && ImGui_ImplOpenGL3_Init(glsl_version);
 }
 
+bool Application::InitializeHeadless() {
+#ifdef _WIN32
+    fprintf(stderr, "Headless mode is not supported on Windows.\n");
+    return false;
+#else
+    headless_ = true;
+
+    /* every thread started from here on inherits the mask, `RunHeadless` takes them with sigwait */
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+
+    Config* config = Config::LoadNew(Config::INI_FILE);
+    if (!config) {
+        fprintf(stdout, "Couldn't load %s, using the default configuration.\n", Config::INI_FILE);
+    }
+    InitializePipeline(config);
+    WatchConfig();
+    return true;
+#endif
+}
+
+void Application::InitializePipeline(Config* config) {
+    EventBus::Instance().subscribe(&Application::OnHotkey);
+    EventBus::Instance().subscribe(&Application::OnMouseButton);
+    EventBus::Instance().subscribe(&Application::OnMouseMotion);
+    EventBus::Instance().subscribe(&Application::OnFocusChanged);
+    /* with the event loop the input is read, handled and sent from that one thread */
+    if (!InitializeEventLoop()) {
+        /* keeps the X record/input threads from running the handlers inline */
+        EventBus::Instance().defer<MouseButtonEvent>(EventQueuePolicy::DropOldest);
+        EventBus::Instance().defer<MouseMotionEvent>(EventQueuePolicy::Coalesce);
+        EventBus::Instance().start_dispatcher();
+    }
+
+    controller_ = new NpadController();
+    mouse_ = new Mouse(controller_, event_loop_ == nullptr);
+
+    Reconfig(config);
+#if _DEBUG
+    Native::GetInstance()->RegisterHotKey(GetKeyScancode(GLFW_KEY_T),
+                                          GetKeyScancode(GLFW_KEY_LEFT_CONTROL));
+#endif
+#if RMB_TRACE
+    Native::GetInstance()->RegisterHotKey(GetKeyScancode(GLFW_KEY_P),
+                                          GetKeyScancode(GLFW_KEY_LEFT_CONTROL));
+#endif
+}
+
 void Application::Run() {
     if (is_running_)
         return;
 
     is_running_ = true;
 
+    if (headless_) {
+        RunHeadless();
+        return;
+    }
+
     ImGui::GetIO().IniFilename = nullptr;
     ImGui::StyleColorsDark();
 
     ImVec4 clear_color = ImVec4(0.45f, 0.55f, 0.60f, 1.00f);
 
     /* worker thread */
-    auto update_thread = std::jthread{[this](std::stop_token stop_token) {
-        while (!stop_token.stop_requested()) {
-            Update();
-            std::this_thread::sleep_for(std::chrono::milliseconds(1));
-        }
-        fprintf(stdout, "Exiting Application.\n");
-    }};
+    auto update_thread =
+        std::jthread{[this](std::stop_token stop_token) { UpdateThread(stop_token); }};
 
     while (!glfwWindowShouldClose(main_window_)) {
         glfwWaitEvents();
+        if (config_changed_.exchange(false)) {
+            main_view_->ReloadConfig();
+        }
         if (glfwGetWindowAttrib(main_window_, GLFW_ICONIFIED)) {
             ImGui_ImplGlfw_Sleep(10);
             continue;
@@ -182,8 +257,144 @@ void Application::Run() {
     }
 }
 
+void Application::RunHeadless() {
+#ifndef _WIN32
+    auto update_thread =
+        std::jthread{[this](std::stop_token stop_token) { UpdateThread(stop_token); }};
+
+    fprintf(stdout, "Running headless, Ctrl+C to exit.\n");
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    int signal = 0;
+    sigwait(&signals, &signal);
+    fprintf(stdout, "Received signal %d.\n", signal);
+#endif
+}
+
+void Application::WatchConfig() {
+#if defined(__linux__)
+    config_watcher_ = new ConfigWatcher(Config::INI_FILE, [this] {
+        config_changed_ = true;
+        /* wakes up whichever thread applies it */
+        if (!headless_)
+            glfwPostEmptyEvent();
+        else if (event_loop_)
+            event_loop_->Wake();
+    });
+#endif
+}
+
+void Application::ReloadConfig() {
+    Config* config = Config::LoadNew(Config::INI_FILE);
+    if (!config) {
+        fprintf(stderr, "Couldn't reload %s, keeping the current configuration.\n",
+                Config::INI_FILE);
+        return;
+    }
+    Reconfig(config);
+    fprintf(stdout, "Reloaded %s.\n", Config::INI_FILE);
+}
+
+void Application::UpdateThread(std::stop_token stop_token) {
+    RMB_TRACE_THREAD("Application");
+    ThreadPriority::Scope priority("Application");
+#if defined(__linux__)
+    if (event_loop_) {
+        auto keyboard_manager = KeyboardManager::GetInstance();
+        event_loop_->Run(
+            stop_token,
+            [this, &keyboard_manager] {
+                Update();
+                keyboard_manager->Update();
+            },
+            [] { return Native::GetInstance()->HasPendingEvents(); });
+        /* nothing runs the keyboard manager anymore, release whatever it still holds */
+        keyboard_manager->Clear();
+        keyboard_manager->Update();
+        fprintf(stdout, "Exiting Application.\n");
+        return;
+    }
+#endif
+    while (!stop_token.stop_requested()) {
+        Update();
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    fprintf(stdout, "Exiting Application.\n");
+}
+
+bool Application::InitializeEventLoop() {
+#if defined(__linux__)
+    constexpr size_t max_fds = 8;
+    int fds[max_fds];
+
+    auto event_loop = new EventLoop();
+    size_t fds_count = 0;
+    if (event_loop->IsInitialized()) {
+        fds_count = Native::GetInstance()->UseEventLoop(fds, max_fds);
+    }
+
+    /* the fds don't need callbacks, `Update` reads all of them after every wake up */
+    bool initialized = fds_count != 0;
+    for (size_t i = 0; initialized && i < fds_count; i++) {
+        initialized = event_loop->AddFd(fds[i], nullptr);
+    }
+    if (initialized) {
+        mouse_timer_ = event_loop->AddTimer([this] { mouse_->Update(); });
+        /* the keyboard manager and the cursor visibility update after every wake up as well */
+        keyboard_timer_ = event_loop->AddTimer(nullptr);
+        cursor_timer_ = event_loop->AddTimer(nullptr);
+        initialized = mouse_timer_ >= 0 && keyboard_timer_ >= 0 && cursor_timer_ >= 0;
+    }
+
+    if (!initialized) {
+        /* `Native::Update` keeps reading every input when it is polled instead */
+        fprintf(stderr, "Event loop is not available, falling back to polling.\n");
+        delete event_loop;
+        return false;
+    }
+
+    KeyboardManager::UseManualUpdate();
+    event_loop_ = event_loop;
+    return true;
+#else
+    return false;
+#endif
+}
+
+void Application::RefreshEventLoopTimers() {
+#if defined(__linux__)
+    if (!event_loop_)
+        return;
+
+    using namespace std::chrono_literals;
+    const auto config = Config::Snapshot();
+    const bool panning = panning_started_;
+    const bool persistent_keys = panning && config->PERSISTANT_KEY_PRESS;
+    event_loop_->SetTimer(mouse_timer_, panning ? Mouse::UPDATE_PERIOD : 0ms);
+    event_loop_->SetTimer(keyboard_timer_,
+                          persistent_keys ? KeyboardManager::UPDATE_PERIOD : 0ms);
+    /* coarse, only has to notice the hide timeout passing */
+    event_loop_->SetTimer(cursor_timer_, config->HIDE_MOUSE ? 500ms : 0ms);
+    /* lets the loop pick up anything queued from this thread, like releasing the keys */
+    event_loop_->Wake();
+#endif
+}
+
 void Application::Update() {
+    RMB_TRACE_SCOPE("Update");
+    /* without a window this thread owns the config */
+    if (headless_ && config_changed_.exchange(false)) {
+        ReloadConfig();
+    }
     Native::GetInstance()->Update();
+    if (recenter_cursor_.exchange(false) && panning_started_ && !pointer_confined_) {
+        Native::GetInstance()->SetMousePos(screen_center_x_, screen_center_y_);
+    }
+    if (const double moved_time = mouse_moved_time_.exchange(0.0); moved_time > 0.0) {
+        UpdateMouseVisibility(moved_time);
+    }
     DetectMouseMove();
 }
 
@@ -196,46 +407,95 @@ void Application::Reconfig(Config* new_conf) {
     else
         Config::Current(new Config());
 
-    Config::Current()->TOGGLE_KEY = glfwGetKeyScancode(Config::Current()->TOGGLE_KEY);
-    Config::Current()->TOGGLE_MODIFIER = glfwGetKeyScancode(Config::Current()->TOGGLE_MODIFIER);
+    Config::Current()->TOGGLE_KEY = GetKeyScancode(Config::Current()->TOGGLE_KEY);
+    Config::Current()->TOGGLE_MODIFIER = GetKeyScancode(Config::Current()->TOGGLE_MODIFIER);
     Native::GetInstance()->RegisterHotKey(Config::Current()->TOGGLE_KEY,
                                           Config::Current()->TOGGLE_MODIFIER);
 
     for (auto i = 0; i < 4; i++) {
         Config::Current()->RIGHT_STICK_KEYS[i] =
-            glfwGetKeyScancode(Config::Current()->RIGHT_STICK_KEYS[i]);
+            GetKeyScancode(Config::Current()->RIGHT_STICK_KEYS[i]);
+        if (Config::Current()->LEFT_STICK_KEYS[i] >= 0)
+            Config::Current()->LEFT_STICK_KEYS[i] =
+                GetKeyScancode(Config::Current()->LEFT_STICK_KEYS[i]);
+        if (Config::Current()->DPAD_KEYS[i] >= 0)
+            Config::Current()->DPAD_KEYS[i] = GetKeyScancode(Config::Current()->DPAD_KEYS[i]);
     }
 
     if (Config::Current()->LEFT_MOUSE_KEY >= 0)
-        Config::Current()->LEFT_MOUSE_KEY = glfwGetKeyScancode(Config::Current()->LEFT_MOUSE_KEY);
+        Config::Current()->LEFT_MOUSE_KEY = GetKeyScancode(Config::Current()->LEFT_MOUSE_KEY);
     if (Config::Current()->RIGHT_MOUSE_KEY >= 0)
-        Config::Current()->RIGHT_MOUSE_KEY = glfwGetKeyScancode(Config::Current()->RIGHT_MOUSE_KEY);
+        Config::Current()->RIGHT_MOUSE_KEY = GetKeyScancode(Config::Current()->RIGHT_MOUSE_KEY);
     if (Config::Current()->MIDDLE_MOUSE_KEY >= 0)
-        Config::Current()->MIDDLE_MOUSE_KEY = glfwGetKeyScancode(Config::Current()->MIDDLE_MOUSE_KEY);
+        Config::Current()->MIDDLE_MOUSE_KEY = GetKeyScancode(Config::Current()->MIDDLE_MOUSE_KEY);
+    for (auto& key : Config::Current()->EXTRA_MOUSE_KEYS) {
+        if (key >= 0)
+            key = GetKeyScancode(key);
+    }
+    for (auto& key : Config::Current()->BUTTON_KEYS) {
+        if (key >= 0)
+            key = GetKeyScancode(key);
+    }
 
+    for (auto& profile : Config::Current()->PROFILES) {
+        for (auto i = 0; i < 4; i++) {
+            auto& key = profile.RIGHT_STICK_KEYS[i];
+            if (key && *key >= 0)
+                key = GetKeyScancode(*key);
+        }
+    }
+    for (auto& macro : Config::Current()->MACROS) {
+        for (auto& step : macro.STEPS) {
+            step.KEY = GetKeyScancode(step.KEY);
+        }
+    }
+
+    /* the input threads only see the new config from here on */
+    Config::Publish();
+
+    mouse_->Configure(*Config::Current());
+    controller_->Configure(*Config::Current());
     controller_->SetPersistentMode(Config::Current()->PERSISTANT_KEY_PRESS);
+    controller_->SetPulseWidthMode(Config::Current()->PULSE_WIDTH_KEY_PRESS,
+                                   Config::Current()->PULSE_WIDTH_PERIOD);
+    if (!controller_->SetVirtualGamepadMode(Config::Current()->VIRTUAL_GAMEPAD)) {
+        fprintf(stderr, "Virtual gamepad is not available, falling back to key presses.\n");
+    }
+    ThreadPriority::Apply(*Config::Current());
+    RefreshEventLoopTimers();
 }
 
 void Application::TogglePanning() {
     if (!panning_started_) {
-        for (int i = 0; i < 4; i++) {
-			// No point in starting the panning if the keys for the right stick are not set.
-            if (Config::Current()->RIGHT_STICK_KEYS[i] < 0)
-                return;
-		}
+        const auto config = Config::Snapshot();
+        // No point in starting the panning if the keys for the mapped outputs are not set.
+        if (!controller_->IsVirtualGamepadMode() && !controller_->HasOutputKeys(*config))
+            return;
 
-        if (Config::Current()->AUTO_FOCUS_EMU_WINDOW) {
-            Native::GetInstance()->SetFocusOnWindow(Config::Current()->TARGET_NAME);
+        if (config->AUTO_FOCUS_EMU_WINDOW) {
+            Native::GetInstance()->SetFocusOnWindow(config->TARGET_NAME);
         }
 
-        const GLFWvidmode* videoMode = glfwGetVideoMode(glfwGetPrimaryMonitor());
-        screen_center_x_ = videoMode->width / 2, screen_center_y_ = videoMode->height / 2;
+        int screen_width = 0, screen_height = 0;
+        if (!headless_) {
+            const GLFWvidmode* videoMode = glfwGetVideoMode(glfwGetPrimaryMonitor());
+            screen_width = videoMode->width, screen_height = videoMode->height;
+        }
+        else if (!Native::GetInstance()->GetScreenSize(&screen_width, &screen_height)) {
+            fprintf(stderr, "Couldn't get the screen size.\n");
+        }
+        screen_center_x_ = screen_width / 2, screen_center_y_ = screen_height / 2;
 
         Native::GetInstance()->SetMousePos(screen_center_x_, screen_center_y_);
+        /* with raw deltas the cursor only needs to stay put, no need to warp it back every move */
+        pointer_confined_ = Native::GetInstance()->HasRawMouseMotion() &&
+                            Native::GetInstance()->ConfinePointer(screen_center_x_, screen_center_y_);
 
         panning_started_ = true;
+        mouse_->SetPanning(true);
+        RefreshEventLoopTimers();
 
-        if (glfwGetWindowAttrib(main_window_, GLFW_ICONIFIED)) {
+        if (headless_ || glfwGetWindowAttrib(main_window_, GLFW_ICONIFIED)) {
             return;
         }
 
@@ -250,7 +510,15 @@ void Application::TogglePanning() {
     }
     else {
         panning_started_ = false;
+        mouse_->SetPanning(false);
+        if (pointer_confined_) {
+            Native::GetInstance()->ReleasePointer();
+            pointer_confined_ = false;
+        }
         controller_->ClearState();
+        /* the controller only lets go of the sticks, nothing should keep playing either */
+        KeyScheduler::GetInstance()->Clear();
+        RefreshEventLoopTimers();
         UpdateMouseVisibility(GetTotalRunningTime());
     }
 }
@@ -258,36 +526,46 @@ void Application::TogglePanning() {
 void Application::DetectMouseMove() {
     static int last_cursor_x = 0, last_cursor_y = 0;
 
-    int x = 0, y = 0;
-    Native::GetInstance()->GetMousePos(&x, &y);
+    /* movements are delivered through `OnMouseMotion` */
+    if (!Native::GetInstance()->HasRawMouseMotion()) {
+        int x = 0, y = 0;
+        Native::GetInstance()->GetMousePos(&x, &y);
 
-    if (x != last_cursor_x || y != last_cursor_y) {
-        last_cursor_x = x;
-        last_cursor_y = y;
-        OnMouseMove(x, y);
+        if (x != last_cursor_x || y != last_cursor_y) {
+            last_cursor_x = x;
+            last_cursor_y = y;
+            OnMouseMove(x, y);
+        }
     }
 
-    if (Config::Current()->HIDE_MOUSE) {
+    if (Config::Snapshot()->HIDE_MOUSE) {
         UpdateMouseVisibility();
     }
 }
 
 void Application::OnHotkey(HotkeyEvent& evt) {
+    const auto config = Config::Snapshot();
     DEBUG_OUT("hot_key: (%d, %d)\n", evt.key, evt.modifier);
 
-    if (Config::Current()->TOGGLE_KEY < 0 ||
-        Config::Current()->TOGGLE_MODIFIER < 0)
+    if (config->TOGGLE_KEY < 0 ||
+        config->TOGGLE_MODIFIER < 0)
         return;
     
     auto app = Application::GetInstance();
 #if _DEBUG
-    if ((int)evt.key == glfwGetKeyScancode(GLFW_KEY_T) &&
-        (int)evt.modifier == glfwGetKeyScancode(GLFW_KEY_LEFT_CONTROL)) {
+    if ((int)evt.key == app->GetKeyScancode(GLFW_KEY_T) &&
+        (int)evt.modifier == app->GetKeyScancode(GLFW_KEY_LEFT_CONTROL) && app->main_view_) {
         app->mouse_->TurnTest(app->main_view_->test_delay, app->main_view_->test_type);
     }
 #endif
-    if (evt.key == (uint32_t)Config::Current()->TOGGLE_KEY &&
-        evt.modifier == (uint32_t)Config::Current()->TOGGLE_MODIFIER)
+#if RMB_TRACE
+    if ((int)evt.key == app->GetKeyScancode(GLFW_KEY_P) &&
+        (int)evt.modifier == app->GetKeyScancode(GLFW_KEY_LEFT_CONTROL)) {
+        RMB_TRACE_DUMP();
+    }
+#endif
+    if (evt.key == (uint32_t)config->TOGGLE_KEY &&
+        evt.modifier == (uint32_t)config->TOGGLE_MODIFIER)
         app->TogglePanning();
 }
 
@@ -295,30 +573,88 @@ void Application::OnMouseButton(MouseButtonEvent& evt) {
 #ifdef _WIN32
     static uint32_t last_key = 0;
 #endif // _WIN32
+    const auto config = Config::Snapshot();
 
     DEBUG_OUT("[%f] button: %d, pressed: %d\n", GetTotalRunningTime(), evt.key, evt.is_pressed);
-    if (!Config::Current()->BIND_MOUSE_BUTTON) {
+    if (!config->BIND_MOUSE_BUTTON) {
+        return;
+    }
+
+    /* a macro replaces whatever else the button is bound to */
+    for (const ConfigMacro& macro : config->MACROS) {
+        if (macro.TRIGGER != evt.key)
+            continue;
+        /* a wheel tick is never released, it only plays a single round. the other macros run to
+         * their end unless they repeat */
+        if (evt.is_pressed)
+            Application::GetInstance()->controller_->PlayMacro(macro, !IsMouseWheel(evt.key));
+        else if (macro.REPEAT > 0.f)
+            Application::GetInstance()->controller_->StopMacro(macro);
+        return;
+    }
+
+    /* a button some output follows doesn't go to its own binding */
+    NpadController* controller = Application::GetInstance()->controller_;
+    if (IsMouseWheel(evt.key) ? evt.is_pressed && controller->TapSourceButton(
+                                                      evt.key, config->WHEEL_TAP_DURATION)
+                              : controller->SetSourceButton(evt.key, evt.is_pressed)) {
+        return;
+    }
+
+    const bool is_extra_button = evt.key >= MOUSE_WHEEL_UP && evt.key <= MOUSE_XBUTTON2;
+    if (Application::GetInstance()->controller_->IsVirtualGamepadMode()) {
+        int pad_button = -1;
+        switch (evt.key) {
+        case MOUSE_LBUTTON:
+            pad_button = config->LEFT_MOUSE_PAD_BUTTON;
+            break;
+        case MOUSE_RBUTTON:
+            pad_button = config->RIGHT_MOUSE_PAD_BUTTON;
+            break;
+        case MOUSE_MBUTTON:
+            pad_button = config->MIDDLE_MOUSE_PAD_BUTTON;
+            break;
+        default:
+            if (is_extra_button)
+                pad_button = config->EXTRA_MOUSE_PAD_BUTTONS[evt.key - MOUSE_WHEEL_UP];
+            break;
+        }
+        if (pad_button >= 0 && IsMouseWheel(evt.key)) {
+            Application::GetInstance()->controller_->TapGamepadButton(pad_button,
+                                                                      config->WHEEL_TAP_DURATION);
+        }
+        else if (pad_button >= 0) {
+            Application::GetInstance()->controller_->SetGamepadButton(pad_button, evt.is_pressed);
+        }
         return;
     }
 
     int key = -1;
     switch (evt.key) {
     case MOUSE_LBUTTON:
-        key = Config::Current()->LEFT_MOUSE_KEY;
+        key = config->LEFT_MOUSE_KEY;
         break;
     case MOUSE_RBUTTON:
-        key = Config::Current()->RIGHT_MOUSE_KEY;
+        key = config->RIGHT_MOUSE_KEY;
         break;
     case MOUSE_MBUTTON:
-        key = Config::Current()->MIDDLE_MOUSE_KEY;
+        key = config->MIDDLE_MOUSE_KEY;
+        break;
+    default:
+        if (is_extra_button)
+            key = config->EXTRA_MOUSE_KEYS[evt.key - MOUSE_WHEEL_UP];
         break;
     }
-    if (key >= 0) {
+    /* a tick has no release, the scheduler lets go of the key on its own */
+    if (key >= 0 && IsMouseWheel(evt.key)) {
+        Application::GetInstance()->controller_->TapButton(key, config->WHEEL_TAP_DURATION);
+    }
+    else if (key >= 0) {
         auto app = Application::GetInstance();
 #ifdef _WIN32
         // fixes the left button press issue when trying to focus on another window
         // other than the target window.
-        const std::string& target_window_name = Config::Current()->TARGET_NAME;
+        const std::string& target_window_name = config->TARGET_NAME;
         if (!Native::GetInstance()->IsMainWindowActive(target_window_name)) {
             if (last_key) {
                 app->controller_->ClearState();
@@ -339,9 +675,23 @@ void Application::OnMouseButton(MouseButtonEvent& evt) {
     }
 }
 
+void Application::OnFocusChanged(FocusChangedEvent& evt) {
+    if (!Config::SelectProfile(evt.window_class, evt.window_title))
+        return;
+
+    /* whatever the old bindings hold down has to be released, the next move uses the new ones */
+    auto app = Application::GetInstance();
+    if (app->panning_started_) {
+        app->controller_->ClearState();
+    }
+}
+
 void Application::OnMouseMove(int x, int y) {
     auto app = Application::GetInstance();
     if (app->panning_started_) {
+        RMB_TRACE_BEGIN(Utils::now_ns());
+        InputTraceWriter::AddMouseDelta(static_cast<float>(x - screen_center_x_),
+                                        static_cast<float>(y - screen_center_y_));
         app->mouse_->MouseMoved(x, y, screen_center_x_, screen_center_y_);
         Native::GetInstance()->SetMousePos(screen_center_x_, screen_center_y_);
     }
@@ -350,6 +700,22 @@ void Application::OnMouseMove(int x, int y) {
     }
 }
 
+void Application::OnMouseMotion(MouseMotionEvent& evt) {
+    auto app = Application::GetInstance();
+    if (app->panning_started_) {
+        RMB_TRACE_BEGIN(evt.published_ns);
+        InputTraceWriter::AddMouseDelta(evt.dx, evt.dy);
+        app->mouse_->MouseMoved(evt.dx, evt.dy, evt.published_ns);
+        /* raw deltas don't depend on the cursor position, just keep it away from the edges */
+        if (!app->pointer_confined_) {
+            app->recenter_cursor_ = true;
+        }
+    }
+    else {
+        app->mouse_moved_time_ = GetTotalRunningTime();
+    }
+}
+
 void Application::UpdateMouseVisibility(double new_moved_time) {
     constexpr double default_mouse_hide_timeout = 2500;
     static double last_mouse_moved = GetTotalRunningTime();
@@ -364,11 +730,15 @@ void Application::UpdateMouseVisibility(double new_moved_time) {
     double time_passed = current_time - last_mouse_moved;
     if (time_passed >= default_mouse_hide_timeout) {
         Native::GetInstance()->CursorHide(
-            Native::GetInstance()->IsMainWindowActive(Config::Current()->TARGET_NAME));
+            Native::GetInstance()->IsMainWindowActive(Config::Snapshot()->TARGET_NAME));
         last_mouse_moved = current_time;
     }
 }
 
+int Application::GetKeyScancode(int key) const {
+    return headless_ ? Native::GetInstance()->GetKeyScancode(key) : glfwGetKeyScancode(key);
+}
+
 void Application::OnKeyCallback(GLFWwindow* window, int key, int scancode, int action, int mods) {
     (void)window;
     switch (action) {
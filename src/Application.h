@@ -1,15 +1,21 @@
 #pragma once
 
+#include <atomic>
 #include <cstdint>
+#include <stop_token>
 #include <string>
 
 struct GLFWwindow;
 struct HotkeyEvent;
 struct MouseButtonEvent;
+struct MouseMotionEvent;
+struct FocusChangedEvent;
 class MainView;
 class Mouse;
 class NpadController;
 class Config;
+class EventLoop;
+class ConfigWatcher;
 
 class Application {
 public:
@@ -24,10 +30,14 @@ public:
     static double GetTotalRunningTime();
 
     bool Initialize(const char* name, uint32_t width, uint32_t height);
+    /* only the input pipeline, no window, GL context or GLFW, configured from `RMB.ini` */
+    bool InitializeHeadless();
 
     void Run();
     void Reconfig(Config* new_conf = nullptr);
     void TogglePanning();
+    /* arms the event loop's timers for the current panning state and config, no-op without one */
+    void RefreshEventLoopTimers();
 
     bool IsPanning() const {
         return panning_started_;
@@ -37,14 +47,31 @@ public:
         return controller_;
     }
 
+    Mouse* GetMouse() const {
+        return mouse_;
+    }
+
 private:
+    /* `config` replaces the current one, the defaults without it */
+    void InitializePipeline(Config* config);
+    bool InitializeEventLoop();
+    void UpdateThread(std::stop_token stop_token);
+    void RunHeadless();
+    /* reloads `RMB.ini` when it changes on disk, applied by the thread which owns the config */
+    void WatchConfig();
+    void ReloadConfig();
     void Update();
     void DetectMouseMove();
     void UpdateMouseVisibility(double new_moved_time = 0.0);
+    /* GLFW key code to scan code, through the platform when GLFW isn't initialized */
+    int GetKeyScancode(int key) const;
 
     static void OnKeyCallback(GLFWwindow* window, int key, int scancode, int action, int mods);
     static void OnHotkey(HotkeyEvent& evt);
     static void OnMouseButton(MouseButtonEvent& evt);
+    static void OnMouseMotion(MouseMotionEvent& evt);
+    /* switches to the profile of the newly focused window */
+    static void OnFocusChanged(FocusChangedEvent& evt);
     static void OnMouseMove(int x, int y);
 
     static Application* instance_;
@@ -53,7 +80,21 @@ private:
     MainView* main_view_ = nullptr;
     Mouse* mouse_ = nullptr;
     NpadController* controller_ = nullptr;
+    EventLoop* event_loop_ = nullptr;
+    ConfigWatcher* config_watcher_ = nullptr;
+    std::atomic_bool config_changed_ = false;
+    /* `OnMouseMotion` may run on the dispatcher thread, it only leaves these for `Update` which
+     * owns the cursor */
+    std::atomic<double> mouse_moved_time_ = 0.0;
+    std::atomic_bool recenter_cursor_ = false;
+    int mouse_timer_ = -1;
+    int keyboard_timer_ = -1;
+    int cursor_timer_ = -1;
 
+    bool headless_ = false;
     bool is_running_ = false;
-    bool panning_started_ = false;
+    /* written by `TogglePanning`, read by the dispatcher and the UI thread too. the pointer is
+     * confined before panning starts and panning stops before it is released */
+    std::atomic_bool panning_started_ = false;
+    std::atomic_bool pointer_confined_ = false;
 };
\ No newline at end of file
@@ -2,6 +2,69 @@
 #include <iniparser.hpp>
 #include "Config.h"
 
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <iterator>
+#include <mutex>
+#include <string_view>
+#include "Utils.h"
+#include "key_scheduler.h"
+#include "virtual_gamepad.h"
+
+/* sections of the left stick, right stick and D-pad, the keys are 0 to 3 in them */
+static constexpr const char* OUTPUT_SECTIONS[3] = {"LeftStick", "RightStick", "DPad"};
+
+/* the buttons are `[Button.0]` to `[Button.7]` after the sticks and the D-pad */
+static std::string GetOutputSection(size_t output) {
+    return output < 3 ? OUTPUT_SECTIONS[output] : "Button." + std::to_string(output - 3);
+}
+/* keys of `EXTRA_MOUSE_KEYS` and `EXTRA_MOUSE_PAD_BUTTONS` in the Mouse and VirtualGamepad
+ * sections */
+static constexpr const char* EXTRA_MOUSE_BUTTONS[6] = {
+    "WheelUp", "WheelDown", "WheelLeft", "WheelRight", "BackButton", "ForwardButton"};
+/* macro triggers, `MOUSE_LBUTTON` is the first one */
+static constexpr std::string_view MOUSE_BUTTONS[9] = {
+    "LeftButton", "RightButton", "MiddleButton", "WheelUp",      "WheelDown",
+    "WheelLeft",  "WheelRight",  "BackButton",   "ForwardButton"};
+
+/* "0:+65, 30:-65", the offset in ms and the GLFW key code, pressed with + and released with - */
+static bool ParseMacroSteps(const std::string& steps, ConfigMacro* macro) {
+    for (const auto& step : Utils::split_str(steps, ",")) {
+        float offset = 0.f;
+        char sign = 0;
+        int key = -1;
+        if (sscanf(step.c_str(), " %f : %c%d", &offset, &sign, &key) != 3 || offset < 0.f ||
+            (sign != '+' && sign != '-') || key < 0) {
+            fprintf(stderr, "Ignoring invalid step \"%s\" of macro \"%s\".\n", step.c_str(),
+                    macro->NAME.c_str());
+            continue;
+        }
+        if (macro->STEPS.size() == KeyScheduler::MAX_MACRO_EVENTS) {
+            fprintf(stderr, "Only %zu steps per macro are supported.\n",
+                    KeyScheduler::MAX_MACRO_EVENTS);
+            break;
+        }
+        macro->STEPS.push_back({offset, key, sign == '+'});
+    }
+
+    std::stable_sort(macro->STEPS.begin(), macro->STEPS.end(),
+                     [](const MacroStep& a, const MacroStep& b) { return a.OFFSET < b.OFFSET; });
+    return !macro->STEPS.empty();
+}
+
+/* unset if `section` doesn't have `key` at all */
+static std::optional<INI::Value> FindValue(const INI::File& ft, const std::string& section,
+                                           const std::string& key) {
+    const INI::Section* found = ft.FindSection(section);
+    if (!found)
+        return std::nullopt;
+    const std::vector<std::string> keys = found->GetSectionKeys();
+    if (std::ranges::find(keys, key) == keys.end())
+        return std::nullopt;
+    return found->GetValue(key);
+}
+
 Config::Config() {
     constexpr int NONE = -1;
 
@@ -14,6 +77,12 @@ Config::Config() {
     RIGHT_STICK_KEYS[2] = GLFW_KEY_I;
     RIGHT_STICK_KEYS[3] = GLFW_KEY_K;
 
+    OUTPUT_THRESHOLDS[2] = 0.5f;
+    for (size_t i = 3; i < OUTPUTS; i++) {
+        OUTPUT_SOURCES[i] = "none";
+        OUTPUT_THRESHOLDS[i] = 0.5f;
+    }
+
     LEFT_MOUSE_KEY = NONE;
     RIGHT_MOUSE_KEY = NONE;
     MIDDLE_MOUSE_KEY = NONE;
@@ -24,6 +93,12 @@ Config::Config() {
     AUTO_FOCUS_EMU_WINDOW = true;
     BIND_MOUSE_BUTTON = true;
     PERSISTANT_KEY_PRESS = false;
+    VIRTUAL_GAMEPAD = false;
+    PULSE_WIDTH_KEY_PRESS = false;
+
+    LEFT_MOUSE_PAD_BUTTON = static_cast<int>(GamepadButton::ZR);
+    RIGHT_MOUSE_PAD_BUTTON = static_cast<int>(GamepadButton::ZL);
+    MIDDLE_MOUSE_PAD_BUTTON = static_cast<int>(GamepadButton::RStick);
 }
 
 Config* Config::Current(Config* change) {
@@ -37,51 +112,280 @@ Config* Config::Current(Config* change) {
     return current_instance;
 }
 
+static std::atomic<std::shared_ptr<const Config>>& SnapshotStorage() {
+    static std::atomic<std::shared_ptr<const Config>> snapshot{std::make_shared<const Config>()};
+    return snapshot;
+}
+
+/* everything `Publish` baked, only the writers of the snapshot touch it */
+struct PublishedConfigs {
+    struct Profile {
+        std::string name;
+        /* lowercase */
+        std::string match;
+        /* `base` with the profile applied */
+        std::shared_ptr<const Config> config;
+    };
+
+    std::mutex mutex;
+    std::shared_ptr<const Config> base = std::make_shared<const Config>();
+    std::vector<Profile> profiles;
+    std::string window_class;
+    std::string window_title;
+    size_t active = NO_PROFILE;
+
+    static constexpr size_t NO_PROFILE = ~size_t(0);
+
+    /* true if the active profile changed */
+    bool Select() {
+        size_t index = NO_PROFILE;
+        for (size_t i = 0; i < profiles.size() && index == NO_PROFILE; i++) {
+            const std::string& match = profiles[i].match;
+            if (window_class.find(match) != std::string::npos ||
+                window_title.find(match) != std::string::npos) {
+                index = i;
+            }
+        }
+        if (index == active)
+            return false;
+
+        active = index;
+        SnapshotStorage().store(index == NO_PROFILE ? base : profiles[index].config,
+                                std::memory_order_release);
+        return true;
+    }
+};
+
+static PublishedConfigs& Published() {
+    static PublishedConfigs published;
+    return published;
+}
+
+std::shared_ptr<const Config> Config::Snapshot() {
+    return SnapshotStorage().load(std::memory_order_acquire);
+}
+
+void Config::Publish() {
+    const Config* current = Current();
+    auto base = std::make_shared<const Config>(*current);
+
+    std::vector<PublishedConfigs::Profile> profiles;
+    profiles.reserve(current->PROFILES.size());
+    for (const ConfigProfile& profile : current->PROFILES) {
+        auto config = std::make_shared<Config>(*current);
+        config->TARGET_NAME = profile.TARGET_NAME.value_or(current->TARGET_NAME);
+        config->SENSITIVITY = profile.SENSITIVITY.value_or(current->SENSITIVITY);
+        for (int i = 0; i < 4; i++) {
+            config->RIGHT_STICK_KEYS[i] =
+                profile.RIGHT_STICK_KEYS[i].value_or(current->RIGHT_STICK_KEYS[i]);
+        }
+        profiles.push_back({profile.NAME, Utils::to_lower(profile.MATCH), std::move(config)});
+    }
+
+    PublishedConfigs& published = Published();
+    std::scoped_lock<std::mutex> lock(published.mutex);
+    published.base = std::move(base);
+    published.profiles = std::move(profiles);
+    /* the profiles may be different ones now, picked again for the same window */
+    published.active = PublishedConfigs::NO_PROFILE;
+    if (!published.Select())
+        SnapshotStorage().store(published.base, std::memory_order_release);
+}
+
+bool Config::HasUnpublishedChanges() {
+    PublishedConfigs& published = Published();
+    std::scoped_lock<std::mutex> lock(published.mutex);
+    return *Current() != *published.base;
+}
+
+bool Config::SelectProfile(const std::string& window_class, const std::string& window_title) {
+    PublishedConfigs& published = Published();
+    std::scoped_lock<std::mutex> lock(published.mutex);
+    published.window_class = Utils::to_lower(window_class);
+    published.window_title = Utils::to_lower(window_title);
+    if (!published.Select())
+        return false;
+
+    if (published.active == PublishedConfigs::NO_PROFILE)
+        fprintf(stdout, "No profile matches the focused window, using the main bindings.\n");
+    else
+        fprintf(stdout, "Switched to profile \"%s\".\n",
+                published.profiles[published.active].name.c_str());
+    return true;
+}
+
 Config* Config::LoadNew(const std::string& file) {
     INI::File ft;
     if (!ft.Load(file))
         return nullptr;
 
+    /* the defaults are GLFW key codes, `Current` holds scan codes once it was applied */
     auto new_conf = new Config();
 
-    new_conf->TARGET_NAME =
-        ft.GetValue("TargetEmulatorWindow", Config::Current()->TARGET_NAME).AsString();
+    new_conf->TARGET_NAME = ft.GetValue("TargetEmulatorWindow", new_conf->TARGET_NAME).AsString();
+
+    new_conf->SENSITIVITY = ft.GetValue("Sensitivity", new_conf->SENSITIVITY).AsT<float>();
+    new_conf->MOUSE_DPI = ft.GetValue("Mouse:Dpi", new_conf->MOUSE_DPI).AsT<float>();
 
-    new_conf->SENSITIVITY = ft.GetValue("Sensitivity", Config::Current()->SENSITIVITY).AsT<float>();
+    new_conf->MOUSE_FILTERS = ft.GetValue("MouseFilter:Stages", new_conf->MOUSE_FILTERS).AsString();
+    new_conf->FILTER_EMA_ALPHA =
+        ft.GetValue("MouseFilter:EmaAlpha", new_conf->FILTER_EMA_ALPHA).AsT<float>();
+    new_conf->FILTER_MIN_CUTOFF =
+        ft.GetValue("MouseFilter:MinCutoff", new_conf->FILTER_MIN_CUTOFF).AsT<float>();
+    new_conf->FILTER_BETA = ft.GetValue("MouseFilter:Beta", new_conf->FILTER_BETA).AsT<float>();
+    new_conf->FILTER_DERIVATIVE_CUTOFF =
+        ft.GetValue("MouseFilter:DerivativeCutoff", new_conf->FILTER_DERIVATIVE_CUTOFF)
+            .AsT<float>();
+    new_conf->FILTER_SLOW_ALPHA =
+        ft.GetValue("MouseFilter:SlowAlpha", new_conf->FILTER_SLOW_ALPHA).AsT<float>();
+    new_conf->FILTER_FAST_ALPHA =
+        ft.GetValue("MouseFilter:FastAlpha", new_conf->FILTER_FAST_ALPHA).AsT<float>();
+    new_conf->FILTER_FAST_SPEED =
+        ft.GetValue("MouseFilter:FastSpeed", new_conf->FILTER_FAST_SPEED).AsT<float>();
+    new_conf->FILTER_DECAY = ft.GetValue("MouseFilter:Decay", new_conf->FILTER_DECAY).AsT<float>();
 
-    new_conf->HIDE_MOUSE = ft.GetValue("HideMouse", Config::Current()->HIDE_MOUSE).AsBool();
+    new_conf->HIDE_MOUSE = ft.GetValue("HideMouse", new_conf->HIDE_MOUSE).AsBool();
     new_conf->AUTO_FOCUS_EMU_WINDOW =
-        ft.GetValue("AutoFocusEmuWindow", Config::Current()->AUTO_FOCUS_EMU_WINDOW).AsBool();
+        ft.GetValue("AutoFocusEmuWindow", new_conf->AUTO_FOCUS_EMU_WINDOW).AsBool();
     new_conf->BIND_MOUSE_BUTTON =
-        ft.GetValue("BindMouseButton", Config::Current()->BIND_MOUSE_BUTTON).AsBool();
+        ft.GetValue("BindMouseButton", new_conf->BIND_MOUSE_BUTTON).AsBool();
     new_conf->PERSISTANT_KEY_PRESS =
-        ft.GetValue("PersistantKeyPress", Config::Current()->PERSISTANT_KEY_PRESS).AsBool();
-
-    new_conf->DEADZONE =
-        ft.GetValue("AnalogProperties:DeadZone", Config::Current()->DEADZONE).AsT<float>();
-    new_conf->RANGE = ft.GetValue("AnalogProperties:Range", Config::Current()->RANGE).AsT<float>();
-    new_conf->THRESHOLD =
-        ft.GetValue("AnalogProperties:Threshold", Config::Current()->THRESHOLD).AsT<float>();
-    new_conf->X_OFFSET =
-        ft.GetValue("AnalogProperties:XOffset", Config::Current()->X_OFFSET).AsT<float>();
-    new_conf->Y_OFFSET =
-        ft.GetValue("AnalogProperties:YOffset", Config::Current()->Y_OFFSET).AsT<float>();
+        ft.GetValue("PersistantKeyPress", new_conf->PERSISTANT_KEY_PRESS).AsBool();
+    new_conf->VIRTUAL_GAMEPAD = ft.GetValue("VirtualGamepad", new_conf->VIRTUAL_GAMEPAD).AsBool();
+    new_conf->PULSE_WIDTH_KEY_PRESS =
+        ft.GetValue("PulseWidthKeyPress", new_conf->PULSE_WIDTH_KEY_PRESS).AsBool();
+    new_conf->PULSE_WIDTH_PERIOD =
+        ft.GetValue("PulseWidthPeriod", new_conf->PULSE_WIDTH_PERIOD).AsT<float>();
+
+    new_conf->THREAD_POLICY = ft.GetValue("Threads:Policy", new_conf->THREAD_POLICY).AsString();
+    new_conf->THREAD_PRIORITY = ft.GetValue("Threads:Priority", new_conf->THREAD_PRIORITY).AsInt();
+    new_conf->THREAD_CPUS = ft.GetValue("Threads:Cpus", new_conf->THREAD_CPUS).AsString();
+    new_conf->LOCK_MEMORY = ft.GetValue("Threads:LockMemory", new_conf->LOCK_MEMORY).AsBool();
+
+    new_conf->CURVE = ft.GetValue("AnalogProperties:Curve", new_conf->CURVE).AsString();
+    new_conf->CURVE_EXPONENT =
+        ft.GetValue("AnalogProperties:CurveExponent", new_conf->CURVE_EXPONENT)
+            .AsT<float>();
+    new_conf->CURVE_POINTS =
+        ft.GetValue("AnalogProperties:CurvePoints", new_conf->CURVE_POINTS).AsString();
+    new_conf->DEADZONE = ft.GetValue("AnalogProperties:DeadZone", new_conf->DEADZONE).AsT<float>();
+    new_conf->RANGE = ft.GetValue("AnalogProperties:Range", new_conf->RANGE).AsT<float>();
+    new_conf->X_OFFSET = ft.GetValue("AnalogProperties:XOffset", new_conf->X_OFFSET).AsT<float>();
+    new_conf->Y_OFFSET = ft.GetValue("AnalogProperties:YOffset", new_conf->Y_OFFSET).AsT<float>();
 
     for (int i = 0; i < 4; i++) {
         std::string key = "RightStick:" + std::to_string(i);
-        new_conf->RIGHT_STICK_KEYS[i] = ft.GetValue(key, Config::Current()->RIGHT_STICK_KEYS[i]).AsInt();
+        new_conf->RIGHT_STICK_KEYS[i] = ft.GetValue(key, new_conf->RIGHT_STICK_KEYS[i]).AsInt();
+        key = "LeftStick:" + std::to_string(i);
+        new_conf->LEFT_STICK_KEYS[i] =
+            ft.GetValue(key, new_conf->LEFT_STICK_KEYS[i]).AsInt();
+        key = "DPad:" + std::to_string(i);
+        new_conf->DPAD_KEYS[i] = ft.GetValue(key, new_conf->DPAD_KEYS[i]).AsInt();
     }
 
-    new_conf->LEFT_MOUSE_KEY =
-        ft.GetValue("Mouse:LeftButton", Config::Current()->LEFT_MOUSE_KEY).AsInt();
-    new_conf->RIGHT_MOUSE_KEY =
-        ft.GetValue("Mouse:RightButton", Config::Current()->RIGHT_MOUSE_KEY).AsInt();
+    for (size_t i = 0; i < OUTPUTS; i++) {
+        const std::string section = GetOutputSection(i);
+        new_conf->OUTPUT_SOURCES[i] =
+            ft.GetValue(section + ":Source", new_conf->OUTPUT_SOURCES[i]).AsString();
+        new_conf->OUTPUT_DEADZONES[i] =
+            ft.GetValue(section + ":DeadZone", new_conf->OUTPUT_DEADZONES[i]).AsT<float>();
+        new_conf->OUTPUT_THRESHOLDS[i] =
+            ft.GetValue(section + ":Threshold", new_conf->OUTPUT_THRESHOLDS[i])
+                .AsT<float>();
+        new_conf->OUTPUT_DIRECTIONS[i] =
+            ft.GetValue(section + ":Direction", new_conf->OUTPUT_DIRECTIONS[i]).AsString();
+    }
+    for (size_t i = 0; i < BUTTON_OUTPUTS; i++) {
+        const std::string section = GetOutputSection(3 + i);
+        new_conf->BUTTON_KEYS[i] = ft.GetValue(section + ":Key", new_conf->BUTTON_KEYS[i]).AsInt();
+        new_conf->BUTTON_PAD_BUTTONS[i] =
+            ft.GetValue(section + ":PadButton", new_conf->BUTTON_PAD_BUTTONS[i]).AsInt();
+    }
+
+    new_conf->LEFT_MOUSE_KEY = ft.GetValue("Mouse:LeftButton", new_conf->LEFT_MOUSE_KEY).AsInt();
+    new_conf->RIGHT_MOUSE_KEY = ft.GetValue("Mouse:RightButton", new_conf->RIGHT_MOUSE_KEY).AsInt();
     new_conf->MIDDLE_MOUSE_KEY =
-        ft.GetValue("Mouse:MiddleButton", Config::Current()->MIDDLE_MOUSE_KEY).AsInt();
+        ft.GetValue("Mouse:MiddleButton", new_conf->MIDDLE_MOUSE_KEY).AsInt();
+
+    new_conf->LEFT_MOUSE_PAD_BUTTON =
+        ft.GetValue("VirtualGamepad:LeftButton", new_conf->LEFT_MOUSE_PAD_BUTTON).AsInt();
+    new_conf->RIGHT_MOUSE_PAD_BUTTON =
+        ft.GetValue("VirtualGamepad:RightButton", new_conf->RIGHT_MOUSE_PAD_BUTTON).AsInt();
+    new_conf->MIDDLE_MOUSE_PAD_BUTTON =
+        ft.GetValue("VirtualGamepad:MiddleButton", new_conf->MIDDLE_MOUSE_PAD_BUTTON)
+            .AsInt();
+
+    for (int i = 0; i < 6; i++) {
+        const std::string button = EXTRA_MOUSE_BUTTONS[i];
+        new_conf->EXTRA_MOUSE_KEYS[i] =
+            ft.GetValue("Mouse:" + button, new_conf->EXTRA_MOUSE_KEYS[i]).AsInt();
+        new_conf->EXTRA_MOUSE_PAD_BUTTONS[i] =
+            ft.GetValue("VirtualGamepad:" + button, new_conf->EXTRA_MOUSE_PAD_BUTTONS[i])
+                .AsInt();
+    }
+    new_conf->WHEEL_TAP_DURATION =
+        ft.GetValue("Mouse:WheelTapDuration", new_conf->WHEEL_TAP_DURATION).AsT<float>();
 
     new_conf->TOGGLE_MODIFIER =
-        ft.GetValue("PanningToggle:Modifier", Config::Current()->TOGGLE_MODIFIER).AsInt();
-    new_conf->TOGGLE_KEY = ft.GetValue("PanningToggle:Key", Config::Current()->TOGGLE_KEY).AsInt();
+        ft.GetValue("PanningToggle:Modifier", new_conf->TOGGLE_MODIFIER).AsInt();
+    new_conf->TOGGLE_KEY = ft.GetValue("PanningToggle:Key", new_conf->TOGGLE_KEY).AsInt();
+
+    /* [Profile.<name>] and its [Profile.<name>.RightStick], anything left out is the main one */
+    const std::string profile_prefix = "Profile.";
+    for (auto it = ft.SectionsBegin(); it != ft.SectionsEnd(); ++it) {
+        const std::string& section = it->first;
+        if (!section.starts_with(profile_prefix) ||
+            section.find('.', profile_prefix.size()) != std::string::npos)
+            continue;
+
+        ConfigProfile profile;
+        profile.NAME = section.substr(profile_prefix.size());
+        profile.MATCH = ft.GetValue(section + ":Match", profile.NAME).AsString();
+        if (profile.MATCH.empty()) {
+            fprintf(stderr, "Ignoring profile \"%s\" without a match.\n", profile.NAME.c_str());
+            continue;
+        }
+        if (auto value = FindValue(ft, section, "TargetEmulatorWindow"))
+            profile.TARGET_NAME = value->AsString();
+        if (auto value = FindValue(ft, section, "Sensitivity"))
+            profile.SENSITIVITY = value->AsT<float>();
+        for (int i = 0; i < 4; i++) {
+            if (auto value = FindValue(ft, section + ".RightStick", std::to_string(i)))
+                profile.RIGHT_STICK_KEYS[i] = value->AsInt();
+        }
+        new_conf->PROFILES.push_back(std::move(profile));
+    }
+
+    /* [Macro.<name>], triggered by a mouse button like the keys of the Mouse section */
+    const std::string macro_prefix = "Macro.";
+    for (auto it = ft.SectionsBegin(); it != ft.SectionsEnd(); ++it) {
+        const std::string& section = it->first;
+        if (!section.starts_with(macro_prefix) ||
+            section.find('.', macro_prefix.size()) != std::string::npos)
+            continue;
+
+        ConfigMacro macro;
+        macro.NAME = section.substr(macro_prefix.size());
+        const std::string trigger = ft.GetValue(section + ":Trigger", std::string()).AsString();
+        const auto button = std::ranges::find(MOUSE_BUTTONS, trigger);
+        if (button == std::end(MOUSE_BUTTONS)) {
+            fprintf(stderr, "Ignoring macro \"%s\" with unknown trigger \"%s\".\n",
+                    macro.NAME.c_str(), trigger.c_str());
+            continue;
+        }
+        macro.TRIGGER = static_cast<uint32_t>(button - std::begin(MOUSE_BUTTONS)) + 1;
+        if (!ParseMacroSteps(ft.GetValue(section + ":Steps", std::string()).AsString(), &macro)) {
+            fprintf(stderr, "Ignoring macro \"%s\" without steps.\n", macro.NAME.c_str());
+            continue;
+        }
+        /* the next round can't start before the last step of this one */
+        macro.REPEAT = ft.GetValue(section + ":Repeat", 0.f).AsT<float>();
+        if (macro.REPEAT > 0.f)
+            macro.REPEAT = std::max({macro.REPEAT, macro.STEPS.back().OFFSET, 1.f});
+        else
+            macro.REPEAT = 0.f;
+        new_conf->MACROS.push_back(std::move(macro));
+    }
 
     return new_conf;
 }
@@ -93,27 +397,76 @@ void Config::Save(const std::string& file) {
     ft.SetValue("TargetEmulatorWindow", this->TARGET_NAME);
 
     ft.SetValue("Sensitivity", this->SENSITIVITY);
+    ft.SetValue("Mouse:Dpi", this->MOUSE_DPI);
+
+    ft.SetValue("MouseFilter:Stages", this->MOUSE_FILTERS);
+    ft.SetValue("MouseFilter:EmaAlpha", this->FILTER_EMA_ALPHA);
+    ft.SetValue("MouseFilter:MinCutoff", this->FILTER_MIN_CUTOFF);
+    ft.SetValue("MouseFilter:Beta", this->FILTER_BETA);
+    ft.SetValue("MouseFilter:DerivativeCutoff", this->FILTER_DERIVATIVE_CUTOFF);
+    ft.SetValue("MouseFilter:SlowAlpha", this->FILTER_SLOW_ALPHA);
+    ft.SetValue("MouseFilter:FastAlpha", this->FILTER_FAST_ALPHA);
+    ft.SetValue("MouseFilter:FastSpeed", this->FILTER_FAST_SPEED);
+    ft.SetValue("MouseFilter:Decay", this->FILTER_DECAY);
 
     ft.SetValue("HideMouse", this->HIDE_MOUSE);
     ft.SetValue("AutoFocusEmuWindow", this->AUTO_FOCUS_EMU_WINDOW);
     ft.SetValue("BindMouseButton", this->BIND_MOUSE_BUTTON);
     ft.SetValue("PersistantKeyPress", this->PERSISTANT_KEY_PRESS);
+    ft.SetValue("VirtualGamepad", this->VIRTUAL_GAMEPAD);
+    ft.SetValue("PulseWidthKeyPress", this->PULSE_WIDTH_KEY_PRESS);
+    ft.SetValue("PulseWidthPeriod", this->PULSE_WIDTH_PERIOD);
+
+    ft.SetValue("Threads:Policy", this->THREAD_POLICY);
+    ft.SetValue("Threads:Priority", this->THREAD_PRIORITY);
+    ft.SetValue("Threads:Cpus", this->THREAD_CPUS);
+    ft.SetValue("Threads:LockMemory", this->LOCK_MEMORY);
 
+    ft.SetValue("AnalogProperties:Curve", this->CURVE);
+    ft.SetValue("AnalogProperties:CurveExponent", this->CURVE_EXPONENT);
+    ft.SetValue("AnalogProperties:CurvePoints", this->CURVE_POINTS);
     ft.SetValue("AnalogProperties:DeadZone", this->DEADZONE);
     ft.SetValue("AnalogProperties:Range", this->RANGE);
-    ft.SetValue("AnalogProperties:Threshold", this->THRESHOLD);
     ft.SetValue("AnalogProperties:XOffset", this->X_OFFSET);
     ft.SetValue("AnalogProperties:YOffset", this->Y_OFFSET);
 
     for (int i = 0; i < 4; i++) {
         std::string key = "RightStick:" + std::to_string(i);
         ft.SetValue(key, this->RIGHT_STICK_KEYS[i]);
+        ft.SetValue("LeftStick:" + std::to_string(i), this->LEFT_STICK_KEYS[i]);
+        ft.SetValue("DPad:" + std::to_string(i), this->DPAD_KEYS[i]);
+    }
+
+    for (size_t i = 0; i < OUTPUTS; i++) {
+        /* the unused buttons would only clutter the file */
+        if (i >= 3 && Utils::to_lower(this->OUTPUT_SOURCES[i]) == "none")
+            continue;
+        const std::string section = GetOutputSection(i);
+        ft.SetValue(section + ":Source", this->OUTPUT_SOURCES[i]);
+        ft.SetValue(section + ":DeadZone", this->OUTPUT_DEADZONES[i]);
+        ft.SetValue(section + ":Threshold", this->OUTPUT_THRESHOLDS[i]);
+        ft.SetValue(section + ":Direction", this->OUTPUT_DIRECTIONS[i]);
+        if (i >= 3) {
+            ft.SetValue(section + ":Key", this->BUTTON_KEYS[i - 3]);
+            ft.SetValue(section + ":PadButton", this->BUTTON_PAD_BUTTONS[i - 3]);
+        }
     }
 
     ft.SetValue("Mouse:LeftButton", this->LEFT_MOUSE_KEY);
     ft.SetValue("Mouse:RightButton", this->RIGHT_MOUSE_KEY);
     ft.SetValue("Mouse:MiddleButton", this->MIDDLE_MOUSE_KEY);
 
+    ft.SetValue("VirtualGamepad:LeftButton", this->LEFT_MOUSE_PAD_BUTTON);
+    ft.SetValue("VirtualGamepad:RightButton", this->RIGHT_MOUSE_PAD_BUTTON);
+    ft.SetValue("VirtualGamepad:MiddleButton", this->MIDDLE_MOUSE_PAD_BUTTON);
+
+    for (int i = 0; i < 6; i++) {
+        const std::string button = EXTRA_MOUSE_BUTTONS[i];
+        ft.SetValue("Mouse:" + button, this->EXTRA_MOUSE_KEYS[i]);
+        ft.SetValue("VirtualGamepad:" + button, this->EXTRA_MOUSE_PAD_BUTTONS[i]);
+    }
+    ft.SetValue("Mouse:WheelTapDuration", this->WHEEL_TAP_DURATION);
+
     ft.SetValue("PanningToggle:Modifier", this->TOGGLE_MODIFIER);
     ft.SetValue("PanningToggle:Key", this->TOGGLE_KEY);
 
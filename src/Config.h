@@ -1,16 +1,70 @@
 #pragma once
+#include <cstddef>
 #include <cstdint>
+#include <memory>
+#include <optional>
 #include <string>
+#include <vector>
+
+/* a `[Profile.<name>]` section of RMB.ini, its bindings replace the main ones while the focused
+ * window's WM_CLASS name or title contains `MATCH`. whatever it leaves unset follows the main ones */
+struct ConfigProfile {
+    bool operator==(const ConfigProfile& other) const = default;
+
+    std::string NAME;
+    std::string MATCH;
+    std::optional<std::string> TARGET_NAME;
+    std::optional<int> RIGHT_STICK_KEYS[4];
+    std::optional<float> SENSITIVITY;
+};
+
+/* a key press or release of a macro, `OFFSET` ms after it was triggered */
+struct MacroStep {
+    bool operator==(const MacroStep& other) const = default;
+
+    float OFFSET;
+    int KEY;
+    bool IS_DOWN;
+};
+
+/* a `[Macro.<name>]` section of RMB.ini, plays `STEPS` when the `TRIGGER` mouse button is pressed.
+ * with a `REPEAT` period they start over every `REPEAT` ms for as long as it is held */
+struct ConfigMacro {
+    bool operator==(const ConfigMacro& other) const = default;
+
+    std::string NAME;
+    /* `MOUSE_LBUTTON` to `MOUSE_XBUTTON2` */
+    uint32_t TRIGGER;
+    /* sorted by offset */
+    std::vector<MacroStep> STEPS;
+    float REPEAT = 0.f;
+};
 
 class Config {
 public:
+    /* the editable config, only touched by the thread which configures RMB (the UI, or the input
+     * thread when headless). the input threads read `Snapshot` */
     static Config* Current(Config* change = nullptr);
     static Config* LoadNew(const std::string& file);
+    /* immutable copy of `Current` from the last `Publish`, grab it once per frame */
+    static std::shared_ptr<const Config> Snapshot();
+    /* swaps in a copy of `Current`, readers holding the old snapshot keep it until they drop it.
+     * every profile is baked into its own copy here as well */
+    static void Publish();
+    /* `Current` differs from what was published last */
+    static bool HasUnpublishedChanges();
+    /* makes the first profile matching the focused window the snapshot, or `Current` without a
+     * match. only swaps already published copies, true if the snapshot changed */
+    static bool SelectProfile(const std::string& window_class, const std::string& window_title);
 
     Config();
 
+    bool operator==(const Config& other) const = default;
+
     void Save(const std::string& file);
 
+    static constexpr const char* INI_FILE = "RMB.ini";
+
     const char* NAME = "RMB";
     const uint32_t WIDTH = 420;
     const uint32_t HEIGHT = 520;
@@ -21,20 +75,87 @@ public:
     int TOGGLE_KEY;
 
     int RIGHT_STICK_KEYS[4]{-1,-1,-1,-1};
+    /* left, right, up and down like `RIGHT_STICK_KEYS` */
+    int LEFT_STICK_KEYS[4]{-1, -1, -1, -1};
+    int DPAD_KEYS[4]{-1, -1, -1, -1};
+    /* the left stick, right stick and D-pad, then the buttons */
+    static constexpr size_t BUTTON_OUTPUTS = 8;
+    static constexpr size_t OUTPUTS = 3 + BUTTON_OUTPUTS;
+    /* indexed by `ControllerOutput`, what drives each output: "none", "mouse", "wheel" or a mouse
+     * button like "BackButton" */
+    std::string OUTPUT_SOURCES[OUTPUTS]{"none", "mouse", "none"};
+    /* radial, applied after the response curve */
+    float OUTPUT_DEADZONES[OUTPUTS]{};
+    /* per axis, values closer to the center are dropped, the D-pad presses a direction past it.
+     * a button driven by the mouse or the wheel is pressed past it */
+    float OUTPUT_THRESHOLDS[OUTPUTS]{};
+    /* "up", "down", "left" or "right", where a mouse button pushes a stick or the D-pad, and which
+     * way the mouse or the wheel has to move to press a button (any way when empty) */
+    std::string OUTPUT_DIRECTIONS[OUTPUTS];
+    /* what each button output presses */
+    int BUTTON_KEYS[BUTTON_OUTPUTS]{-1, -1, -1, -1, -1, -1, -1, -1};
+    int BUTTON_PAD_BUTTONS[BUTTON_OUTPUTS]{-1, -1, -1, -1, -1, -1, -1, -1};
     int LEFT_MOUSE_KEY;
     int RIGHT_MOUSE_KEY;
     int MIDDLE_MOUSE_KEY;
+    /* wheel up, down, left and right, then the back and forward side buttons (`MOUSE_WHEEL_UP`
+     * to `MOUSE_XBUTTON2`). every wheel tick taps its key for `WHEEL_TAP_DURATION` ms */
+    int EXTRA_MOUSE_KEYS[6]{-1, -1, -1, -1, -1, -1};
+    float WHEEL_TAP_DURATION = 40.f;
 
     float SENSITIVITY;
+    /* counts per inch of the mouse, raw deltas are normalised to 800 so the same hand movement
+     * turns the camera the same amount on any mouse */
+    float MOUSE_DPI = 800.f;
+
+    /* comma separated chain of "none", "yuzu", "ema", "oneeuro" and "adaptive" stages, each raw
+     * mouse sample goes through them */
+    std::string MOUSE_FILTERS = "yuzu";
+    float FILTER_EMA_ALPHA = 0.69f;
+    /* One-Euro, the cutoff in Hz rises from `MIN_CUTOFF` by `BETA` times the speed */
+    float FILTER_MIN_CUTOFF = 1.0f;
+    float FILTER_BETA = 0.05f;
+    float FILTER_DERIVATIVE_CUTOFF = 1.0f;
+    /* adaptive, the alpha moves from slow to fast up to `FAST_SPEED` pixels per sample */
+    float FILTER_SLOW_ALPHA = 0.2f;
+    float FILTER_FAST_ALPHA = 0.9f;
+    float FILTER_FAST_SPEED = 20.f;
+    /* the filtered movement is scaled by this every mouse tick */
+    float FILTER_DECAY = 0.76f;
 
     bool HIDE_MOUSE;
     bool AUTO_FOCUS_EMU_WINDOW;
     bool BIND_MOUSE_BUTTON;
     bool PERSISTANT_KEY_PRESS;
+    bool VIRTUAL_GAMEPAD;
+    bool PULSE_WIDTH_KEY_PRESS;
+    float PULSE_WIDTH_PERIOD = 8.0f;
+
+    /* `GamepadButton`s pressed by the mouse buttons when the virtual gamepad is used */
+    int LEFT_MOUSE_PAD_BUTTON;
+    int RIGHT_MOUSE_PAD_BUTTON;
+    int MIDDLE_MOUSE_PAD_BUTTON;
+    int EXTRA_MOUSE_PAD_BUTTONS[6]{-1, -1, -1, -1, -1, -1};
+
+    /* input pipeline threads, "normal", "fifo" or "rr" with a 1-99 real-time priority, pinned to
+     * cpus like "2,3" or "2-3" when not empty */
+    std::string THREAD_POLICY = "normal";
+    int THREAD_PRIORITY = 10;
+    std::string THREAD_CPUS;
+    bool LOCK_MEMORY = false;
+
+    /* "linear", "power", "scurve" or "custom" through `CURVE_POINTS` like "0.5:0.2,1:1" */
+    std::string CURVE = "linear";
+    float CURVE_EXPONENT = 2.f;
+    std::string CURVE_POINTS = "1:1";
 
     float DEADZONE = 0.15f;
     float RANGE = 0.95f;
-    float THRESHOLD = 0.5f;
     float X_OFFSET = 0.0f;
     float Y_OFFSET = 0.0f;
+
+    /* sorted by name, the first match wins */
+    std::vector<ConfigProfile> PROFILES;
+    /* sorted by name, only the first macro of a trigger is used */
+    std::vector<ConfigMacro> MACROS;
 };
\ No newline at end of file
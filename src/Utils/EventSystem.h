@@ -1,45 +1,209 @@
 #pragma once
-#include <list>
-#include <memory>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
 #include <mutex>
-#include <typeindex>
-#include <unordered_map>
-#include <queue>
+#include <new>
+#include <optional>
+#include <stop_token>
+#include <thread>
+#include <type_traits>
+#include <typeinfo>
+
+#include "Tracer.h"
+#include "Utils.h"
 
 struct Event {
+    /* set by `EventBus::publish` and right before the handlers are called, the difference is the
+     * time spent in the deferred queue */
+    uint64_t published_ns = 0;
+    uint64_t dispatched_ns = 0;
+
 protected:
     virtual ~Event() = default;
 };
 
-class HandlerFunctionBase {
+/* Per event type handler table. Handlers are only ever appended, a slot is written before the
+ * count is release-stored, so `Dispatch` can walk the table without taking any lock. */
+template <class EventType>
+class EventHandlers {
 public:
-    inline void exec(Event& evnt) {
-        call(evnt);
+    using Function = void (*)(EventType&);
+    static constexpr size_t MAX_HANDLERS = 8;
+
+    static bool Add(Function function) {
+        const size_t count = count_.load(std::memory_order_relaxed);
+        if (count >= MAX_HANDLERS) {
+            return false;
+        }
+        functions_[count] = function;
+        count_.store(count + 1, std::memory_order_release);
+        return true;
     }
 
-    virtual ~HandlerFunctionBase() = default;
+    static inline void Dispatch(EventType& evnt) {
+        const size_t count = count_.load(std::memory_order_acquire);
+        for (size_t i = 0; i < count; i++) {
+            functions_[i](evnt);
+        }
+    }
 
 private:
-    virtual void call(Event& evnt) = 0;
+    inline static Function functions_[MAX_HANDLERS]{};
+    inline static std::atomic_size_t count_ = 0;
 };
 
+/* what a full deferred queue does with a new event */
+enum class EventQueuePolicy {
+    DropOldest,
+    /* merges into a pending overflow event through `EventType::Merge`, the merge must not depend
+     * on ordering (e.g. summing motion deltas). Falls back to `DropOldest` without `Merge` */
+    Coalesce,
+};
+
+/* Bounded MPMC ring (Vyukov) per event type, every publisher can push and the dispatcher thread
+ * is the consumer. Publishers also pop when dropping the oldest event. */
 template <class EventType>
-class FunctionHandler : public HandlerFunctionBase {
+class EventQueue {
 public:
-    using Function = void (*)(EventType&);
+    static constexpr size_t CAPACITY = 256;
 
-    FunctionHandler(Function function) : function{function} {};
+    static bool IsEnabled() {
+        return enabled_.load(std::memory_order_acquire);
+    }
 
-    inline void call(Event& evnt) override {
-        (*function)(static_cast<EventType&>(evnt));
+    static bool Enable(EventQueuePolicy policy) {
+        policy_.store(policy, std::memory_order_relaxed);
+        if (IsEnabled()) {
+            return false;
+        }
+        for (size_t i = 0; i < CAPACITY; i++) {
+            cells_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+        enabled_.store(true, std::memory_order_release);
+        return true;
     }
 
-    bool compare(const Function& rhs_f) const {
-        return rhs_f == function;
+    static void Push(const EventType& evnt) {
+        while (!TryPush(evnt)) {
+            if constexpr (requires(EventType& a, const EventType& b) { a.Merge(b); }) {
+                if (policy_.load(std::memory_order_relaxed) == EventQueuePolicy::Coalesce) {
+                    while (overflow_lock_.test_and_set(std::memory_order_acquire)) {
+                    }
+                    if (overflow_)
+                        overflow_->Merge(evnt);
+                    else
+                        overflow_.emplace(evnt);
+                    has_overflow_.store(true, std::memory_order_relaxed);
+                    overflow_lock_.clear(std::memory_order_release);
+                    return;
+                }
+            }
+            if (TryPop()) {
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+            }
+        }
+    }
+
+    static void Drain() {
+        while (auto evnt = TryPop()) {
+            Dispatch(*evnt);
+        }
+
+        if (has_overflow_.load(std::memory_order_relaxed)) {
+            std::optional<EventType> evnt;
+            while (overflow_lock_.test_and_set(std::memory_order_acquire)) {
+            }
+            evnt.swap(overflow_);
+            has_overflow_.store(false, std::memory_order_relaxed);
+            overflow_lock_.clear(std::memory_order_release);
+            if (evnt)
+                Dispatch(*evnt);
+        }
+    }
+
+    static void Report() {
+        DEBUG_OUT("EventBus: %s dropped: %zu, max queue delay: %.3fms\n", typeid(EventType).name(),
+                  dropped_.load(), max_delay_ns_ / 1e6);
     }
 
 private:
-    Function function;
+    struct Cell {
+        std::atomic_size_t sequence;
+        alignas(EventType) unsigned char storage[sizeof(EventType)];
+    };
+    static constexpr size_t MASK = CAPACITY - 1;
+    static_assert((CAPACITY & MASK) == 0, "capacity must be a power of two");
+
+    static bool TryPush(const EventType& evnt) {
+        size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+        Cell* cell;
+        for (;;) {
+            cell = &cells_[pos & MASK];
+            const size_t seq = cell->sequence.load(std::memory_order_acquire);
+            const intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+            if (diff == 0) {
+                if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            }
+            else if (diff < 0) {
+                return false;
+            }
+            else {
+                pos = enqueue_pos_.load(std::memory_order_relaxed);
+            }
+        }
+        new (cell->storage) EventType(evnt);
+        cell->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    static std::optional<EventType> TryPop() {
+        size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+        Cell* cell;
+        for (;;) {
+            cell = &cells_[pos & MASK];
+            const size_t seq = cell->sequence.load(std::memory_order_acquire);
+            const intptr_t diff = (intptr_t)seq - (intptr_t)(pos + 1);
+            if (diff == 0) {
+                if (dequeue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+                    break;
+            }
+            else if (diff < 0) {
+                return std::nullopt;
+            }
+            else {
+                pos = dequeue_pos_.load(std::memory_order_relaxed);
+            }
+        }
+        EventType* stored = std::launder(reinterpret_cast<EventType*>(cell->storage));
+        std::optional<EventType> evnt{*stored};
+        stored->~EventType();
+        cell->sequence.store(pos + MASK + 1, std::memory_order_release);
+        return evnt;
+    }
+
+    static void Dispatch(EventType& evnt) {
+        evnt.dispatched_ns = Utils::now_ns();
+        const uint64_t delay = evnt.dispatched_ns - evnt.published_ns;
+        if (delay > max_delay_ns_)
+            max_delay_ns_ = delay;
+        EventHandlers<EventType>::Dispatch(evnt);
+    }
+
+    inline static Cell cells_[CAPACITY];
+    alignas(64) inline static std::atomic_size_t enqueue_pos_ = 0;
+    alignas(64) inline static std::atomic_size_t dequeue_pos_ = 0;
+    inline static std::atomic_bool enabled_ = false;
+    /* may change while the publishers push */
+    inline static std::atomic<EventQueuePolicy> policy_ = EventQueuePolicy::DropOldest;
+    inline static std::atomic_flag overflow_lock_;
+    inline static std::optional<EventType> overflow_;
+    inline static std::atomic_bool has_overflow_ = false;
+    inline static std::atomic_size_t dropped_ = 0;
+    /* only touched by the dispatcher thread */
+    inline static uint64_t max_delay_ns_ = 0;
 };
 
 class EventBus {
@@ -55,34 +219,106 @@ public:
     EventBus(EventBus const&) = delete;
     void operator=(EventBus const&) = delete;
 
+    ~EventBus() {
+        stop_dispatcher();
+    }
+
+    /* lock and allocation free, handlers are called on the publishing thread unless the event
+     * type was deferred, then they are called later on the dispatcher thread */
     template <typename EventType>
     void publish(EventType&& evnt) {
-        std::scoped_lock<std::mutex> lock_guard(mutex);
+        using Type = std::remove_cvref_t<EventType>;
+        Type& typed_evnt = static_cast<Type&>(evnt);
+        typed_evnt.published_ns = Utils::now_ns();
 
-        if (!subscribers.contains(typeid(EventType))) {
+        if (EventQueue<Type>::IsEnabled()) {
+            EventQueue<Type>::Push(typed_evnt);
+            pending_.fetch_add(1, std::memory_order_release);
+            pending_.notify_one();
             return;
         }
 
-        for (auto& handler : subscribers[typeid(EventType)]) {
-            handler->exec(std::forward<EventType&>(evnt));
-        }
+        typed_evnt.dispatched_ns = typed_evnt.published_ns;
+        EventHandlers<Type>::Dispatch(typed_evnt);
     }
 
+    /* meant to be called at startup, the lock only serializes subscribers against each other */
     template <class EventType>
     void subscribe(void (*function)(EventType&)) {
         std::scoped_lock<std::mutex> lock_guard(mutex);
 
-        if (!subscribers.contains(typeid(EventType))) {
-            subscribers[typeid(EventType)] = HandlerList();
+        if (!EventHandlers<EventType>::Add(function)) {
+            fprintf(stderr, "EventBus: too many handlers for %s\n", typeid(EventType).name());
+        }
+    }
+
+    /* from now on `EventType` is queued by `publish` and delivered on the dispatcher thread */
+    template <class EventType>
+    void defer(EventQueuePolicy policy) {
+        std::scoped_lock<std::mutex> lock_guard(mutex);
+
+        if (!EventQueue<EventType>::Enable(policy)) {
+            return;
+        }
+
+        const size_t count = deferred_count_.load(std::memory_order_relaxed);
+        if (count >= MAX_DEFERRED_TYPES) {
+            fprintf(stderr, "EventBus: too many deferred event types\n");
+            return;
+        }
+        deferred_[count] = {&EventQueue<EventType>::Drain, &EventQueue<EventType>::Report};
+        deferred_count_.store(count + 1, std::memory_order_release);
+    }
+
+    void start_dispatcher() {
+        std::scoped_lock<std::mutex> lock_guard(mutex);
+        if (dispatcher_.joinable()) {
+            return;
+        }
+
+        dispatcher_ = std::jthread{[this](std::stop_token stop_token) {
+            RMB_TRACE_THREAD("EventDispatcher");
+            while (!stop_token.stop_requested()) {
+                const uint32_t seen = pending_.load(std::memory_order_acquire);
+                const size_t count = deferred_count_.load(std::memory_order_acquire);
+                {
+                    RMB_TRACE_SCOPE("Drain");
+                    for (size_t i = 0; i < count; i++) {
+                        deferred_[i].drain();
+                    }
+                }
+                pending_.wait(seen, std::memory_order_acquire);
+            }
+
+            const size_t count = deferred_count_.load(std::memory_order_acquire);
+            for (size_t i = 0; i < count; i++) {
+                deferred_[i].report();
+            }
+        }};
+    }
+
+    void stop_dispatcher() {
+        std::scoped_lock<std::mutex> lock_guard(mutex);
+        if (!dispatcher_.joinable()) {
+            return;
         }
 
-        subscribers[typeid(EventType)].push_back(
-            std::make_unique<FunctionHandler<EventType>>(function));
+        dispatcher_.request_stop();
+        pending_.fetch_add(1, std::memory_order_release);
+        pending_.notify_all();
+        dispatcher_.join();
     }
 
 private:
-    using HandlerList = std::list<std::unique_ptr<HandlerFunctionBase>>;
+    struct DeferredType {
+        void (*drain)();
+        void (*report)();
+    };
+    static constexpr size_t MAX_DEFERRED_TYPES = 8;
 
-    std::unordered_map<std::type_index, HandlerList> subscribers;
+    DeferredType deferred_[MAX_DEFERRED_TYPES]{};
+    std::atomic_size_t deferred_count_ = 0;
+    std::atomic_uint32_t pending_ = 0;
+    std::jthread dispatcher_;
     mutable std::mutex mutex;
 };
\ No newline at end of file
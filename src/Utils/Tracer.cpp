@@ -0,0 +1,268 @@
+#include "Tracer.h"
+
+#if RMB_TRACE
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <ctime>
+#include <iterator>
+#include <mutex>
+#include <stop_token>
+#include <thread>
+#include <vector>
+
+#include "Utils.h"
+
+namespace {
+/* ~16 seconds of 1ms thread activity */
+constexpr size_t RING_SIZE = 16384;
+constexpr size_t RING_MASK = RING_SIZE - 1;
+constexpr size_t MAX_RINGS = 32;
+
+constexpr const char* STAGE_NAMES[] = {
+    "Input", "MouseMoved", "MouseTick", "SetStick", "KeyQueued", "KeysSent",
+};
+static_assert(std::size(STAGE_NAMES) == static_cast<size_t>(TraceStage::Count));
+/* `Record::stage` of thread activity spans, `latency_ns` holds the duration */
+constexpr uint8_t SPAN_RECORD = 0xff;
+
+struct Record {
+    std::atomic_uint64_t timestamp_ns;
+    std::atomic_uint64_t latency_ns;
+    std::atomic<const char*> name;
+    std::atomic_uint8_t stage;
+};
+
+/* single writer (the owning thread), `Report` reads it from whatever thread it is called on */
+struct Ring {
+    std::atomic_size_t head = 0;
+    std::atomic<const char*> thread_name = nullptr;
+    Record records[RING_SIZE];
+};
+
+std::atomic<Ring*> rings[MAX_RINGS];
+std::atomic_size_t rings_count = 0;
+
+/* origin of the input not yet picked up by a `Mouse` tick, and of the one being output */
+std::atomic_uint64_t pending_origin = 0;
+std::atomic_uint64_t active_origin = 0;
+
+Ring* ThreadRing() {
+    /* rings are never freed, so samples of exited threads still show up in the report */
+    thread_local Ring* ring = []() -> Ring* {
+        const size_t index = rings_count.fetch_add(1, std::memory_order_relaxed);
+        if (index >= MAX_RINGS) {
+            return nullptr;
+        }
+        Ring* new_ring = new Ring();
+        rings[index].store(new_ring, std::memory_order_release);
+        return new_ring;
+    }();
+    return ring;
+}
+
+void Push(uint8_t stage, const char* name, uint64_t timestamp, uint64_t latency) {
+    Ring* ring = ThreadRing();
+    if (!ring) {
+        return;
+    }
+
+    const size_t head = ring->head.load(std::memory_order_relaxed);
+    Record& record = ring->records[head & RING_MASK];
+    record.timestamp_ns.store(timestamp, std::memory_order_relaxed);
+    record.latency_ns.store(latency, std::memory_order_relaxed);
+    record.name.store(name, std::memory_order_relaxed);
+    record.stage.store(stage, std::memory_order_relaxed);
+    ring->head.store(head + 1, std::memory_order_release);
+}
+
+void Push(TraceStage stage, uint64_t now, uint64_t origin) {
+    Push(static_cast<uint8_t>(stage), STAGE_NAMES[static_cast<size_t>(stage)], now,
+         now > origin ? now - origin : 0);
+}
+
+/* calls `fn` for every record still in the rings, oldest first per ring */
+template <typename Fn>
+void ForEachRecord(Fn&& fn) {
+    const size_t count = std::min(rings_count.load(std::memory_order_relaxed), MAX_RINGS);
+    for (size_t i = 0; i < count; i++) {
+        const Ring* ring = rings[i].load(std::memory_order_acquire);
+        if (!ring) {
+            continue;
+        }
+        const size_t head = ring->head.load(std::memory_order_acquire);
+        const size_t tail = head > RING_SIZE ? head - RING_SIZE : 0;
+        for (size_t j = tail; j < head; j++) {
+            const Record& record = ring->records[j & RING_MASK];
+            fn(i, record.stage.load(std::memory_order_relaxed),
+               record.name.load(std::memory_order_relaxed),
+               record.timestamp_ns.load(std::memory_order_relaxed),
+               record.latency_ns.load(std::memory_order_relaxed));
+        }
+    }
+}
+
+void WriteChromeTrace() {
+    static unsigned dump_count = 0;
+    char path[64];
+    snprintf(path, sizeof(path), "rmb-trace-%lld-%u.json",
+             static_cast<long long>(std::time(nullptr)), dump_count++);
+    FILE* out = fopen(path, "w");
+    if (!out) {
+        fprintf(stderr, "Tracer: couldn't open %s for writing\n", path);
+        return;
+    }
+
+    fprintf(out, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+    bool first = true;
+    const size_t count = std::min(rings_count.load(std::memory_order_relaxed), MAX_RINGS);
+    for (size_t i = 0; i < count; i++) {
+        const Ring* ring = rings[i].load(std::memory_order_acquire);
+        const char* thread_name = ring ? ring->thread_name.load(std::memory_order_relaxed) : nullptr;
+        if (!thread_name) {
+            continue;
+        }
+        fprintf(out, "%s{\"ph\":\"M\",\"name\":\"thread_name\",\"pid\":1,\"tid\":%zu,"
+                     "\"args\":{\"name\":\"%s\"}}",
+                first ? "" : ",\n", i, thread_name);
+        first = false;
+    }
+
+    ForEachRecord([&](size_t tid, uint8_t stage, const char* name, uint64_t timestamp,
+                      uint64_t latency) {
+        if (!name) {
+            return;
+        }
+        if (stage == SPAN_RECORD) {
+            fprintf(out, "%s{\"ph\":\"X\",\"name\":\"%s\",\"pid\":1,\"tid\":%zu,\"ts\":%.3f,"
+                         "\"dur\":%.3f}",
+                    first ? "" : ",\n", name, tid, timestamp / 1e3, latency / 1e3);
+        }
+        else {
+            fprintf(out, "%s{\"ph\":\"i\",\"s\":\"t\",\"name\":\"%s\",\"pid\":1,\"tid\":%zu,"
+                         "\"ts\":%.3f,\"args\":{\"latency_ms\":%.3f}}",
+                    first ? "" : ",\n", name, tid, timestamp / 1e3, latency / 1e6);
+        }
+        first = false;
+    });
+
+    fprintf(out, "\n]}\n");
+    fclose(out);
+    fprintf(stdout, "Tracer: wrote %s\n", path);
+}
+
+/* the JSON is written here so the traced threads only ever touch their rings */
+std::atomic_uint32_t dump_requests = 0;
+std::mutex writer_mutex;
+struct Writer {
+    std::jthread thread;
+
+    void Stop() {
+        if (thread.joinable()) {
+            thread.request_stop();
+            dump_requests.fetch_add(1, std::memory_order_release);
+            dump_requests.notify_one();
+            thread.join();
+        }
+    }
+
+    ~Writer() {
+        Stop();
+    }
+} writer;
+} // namespace
+
+void Tracer::Begin(uint64_t origin_ns) {
+    uint64_t expected = 0;
+    pending_origin.compare_exchange_strong(expected, origin_ns, std::memory_order_relaxed);
+    Push(TraceStage::Input, Utils::now_ns(), origin_ns);
+}
+
+void Tracer::Tick() {
+    const uint64_t origin = pending_origin.exchange(0, std::memory_order_relaxed);
+    active_origin.store(origin, std::memory_order_relaxed);
+    if (origin) {
+        Push(TraceStage::MouseTick, Utils::now_ns(), origin);
+    }
+}
+
+void Tracer::Stamp(TraceStage stage) {
+    const uint64_t origin = stage < TraceStage::MouseTick
+                                ? pending_origin.load(std::memory_order_relaxed)
+                                : active_origin.load(std::memory_order_relaxed);
+    if (origin) {
+        Push(stage, Utils::now_ns(), origin);
+    }
+}
+
+void Tracer::End(TraceStage stage) {
+    const uint64_t origin = active_origin.exchange(0, std::memory_order_relaxed);
+    if (origin) {
+        Push(stage, Utils::now_ns(), origin);
+    }
+}
+
+void Tracer::Report(FILE* out) {
+    std::vector<uint64_t> latencies[static_cast<size_t>(TraceStage::Count)];
+
+    ForEachRecord([&](size_t, uint8_t stage, const char*, uint64_t, uint64_t latency) {
+        if (stage < static_cast<uint8_t>(TraceStage::Count)) {
+            latencies[stage].push_back(latency);
+        }
+    });
+
+    fprintf(out, "%-12s %8s %10s %10s %10s\n", "stage", "samples", "p50(ms)", "p99(ms)", "max(ms)");
+    for (size_t stage = 0; stage < std::size(latencies); stage++) {
+        auto& values = latencies[stage];
+        if (values.empty()) {
+            fprintf(out, "%-12s %8d\n", STAGE_NAMES[stage], 0);
+            continue;
+        }
+        std::sort(values.begin(), values.end());
+        const size_t n = values.size();
+        fprintf(out, "%-12s %8zu %10.3f %10.3f %10.3f\n", STAGE_NAMES[stage], n,
+                values[n / 2] / 1e6, values[std::min(n - 1, n * 99 / 100)] / 1e6,
+                values.back() / 1e6);
+    }
+}
+
+void Tracer::SetThreadName(const char* name) {
+    if (Ring* ring = ThreadRing()) {
+        ring->thread_name.store(name, std::memory_order_relaxed);
+    }
+}
+
+void Tracer::Span(const char* name, uint64_t start_ns) {
+    const uint64_t now = Utils::now_ns();
+    Push(SPAN_RECORD, name, start_ns, now - start_ns);
+}
+
+void Tracer::RequestDump() {
+    {
+        std::scoped_lock<std::mutex> lock{writer_mutex};
+        if (!writer.thread.joinable()) {
+            writer.thread = std::jthread{[](std::stop_token stop_token) {
+                uint32_t handled = 0;
+                while (!stop_token.stop_requested()) {
+                    dump_requests.wait(handled, std::memory_order_acquire);
+                    const uint32_t requested = dump_requests.load(std::memory_order_acquire);
+                    if (requested != handled && !stop_token.stop_requested()) {
+                        WriteChromeTrace();
+                    }
+                    handled = requested;
+                }
+            }};
+        }
+    }
+    dump_requests.fetch_add(1, std::memory_order_release);
+    dump_requests.notify_one();
+}
+
+void Tracer::Shutdown() {
+    {
+        std::scoped_lock<std::mutex> lock{writer_mutex};
+        writer.Stop();
+    }
+    WriteChromeTrace();
+}
+#endif
\ No newline at end of file
@@ -0,0 +1,98 @@
+#pragma once
+
+/* Input latency tracer, compiled in only with `RMB_TRACE` (`BUILD_TRACE` in .nob/nob_config.h).
+ *
+ * A sample starts at `RMB_TRACE_BEGIN` with the time the input was observed, every later stage
+ * records how long after that origin it ran. `RMB_TRACE_TICK` hands the pending input over to the
+ * output side (the `Mouse` tick), `RMB_TRACE_END` closes it once the keys reached the server.
+ *
+ * `RMB_TRACE_SCOPE` records thread activity, `RMB_TRACE_DUMP` has a writer thread export the
+ * recent history of every ring as Chrome `trace_event` JSON (chrome://tracing, Perfetto). */
+#if RMB_TRACE
+#include <cstdint>
+#include <cstdio>
+
+#include "Utils.h"
+
+enum class TraceStage : uint8_t {
+    Input,
+    MouseMoved,
+    MouseTick,
+    SetStick,
+    KeyQueued,
+    KeysSent,
+    Count,
+};
+
+namespace Tracer {
+void Begin(uint64_t origin_ns);
+void Tick();
+void Stamp(TraceStage stage);
+void End(TraceStage stage);
+/* p50/p99/max of every stage over the samples still in the per thread rings */
+void Report(FILE* out);
+
+void SetThreadName(const char* name);
+/* `name` must outlive the tracer, string literals only */
+void Span(const char* name, uint64_t start_ns);
+void RequestDump();
+/* stops the writer thread and writes a last dump from the calling thread */
+void Shutdown();
+
+class Scope {
+public:
+    explicit Scope(const char* name) : name_(name), start_ns_(Utils::now_ns()) {}
+    ~Scope() {
+        Span(name_, start_ns_);
+    }
+
+    Scope(const Scope&) = delete;
+    Scope& operator=(const Scope&) = delete;
+
+private:
+    const char* name_;
+    uint64_t start_ns_;
+};
+} // namespace Tracer
+
+#define RMB_TRACE_CONCAT_(a, b) a##b
+#define RMB_TRACE_CONCAT(a, b) RMB_TRACE_CONCAT_(a, b)
+
+#define RMB_TRACE_BEGIN(origin_ns) Tracer::Begin(origin_ns)
+#define RMB_TRACE_TICK() Tracer::Tick()
+#define RMB_TRACE_STAMP(stage) Tracer::Stamp(TraceStage::stage)
+#define RMB_TRACE_END(stage) Tracer::End(TraceStage::stage)
+#define RMB_TRACE_REPORT() Tracer::Report(stdout)
+#define RMB_TRACE_THREAD(name) Tracer::SetThreadName(name)
+#define RMB_TRACE_SCOPE(name) Tracer::Scope RMB_TRACE_CONCAT(trace_scope_, __LINE__){name}
+#define RMB_TRACE_DUMP() Tracer::RequestDump()
+#define RMB_TRACE_SHUTDOWN() Tracer::Shutdown()
+#else
+#define RMB_TRACE_BEGIN(origin_ns)                                                                 \
+    do {                                                                                           \
+    } while (0)
+#define RMB_TRACE_TICK()                                                                           \
+    do {                                                                                           \
+    } while (0)
+#define RMB_TRACE_STAMP(stage)                                                                     \
+    do {                                                                                           \
+    } while (0)
+#define RMB_TRACE_END(stage)                                                                       \
+    do {                                                                                           \
+    } while (0)
+#define RMB_TRACE_REPORT()                                                                         \
+    do {                                                                                           \
+    } while (0)
+#define RMB_TRACE_THREAD(name)                                                                     \
+    do {                                                                                           \
+    } while (0)
+#define RMB_TRACE_SCOPE(name)                                                                      \
+    do {                                                                                           \
+    } while (0)
+#define RMB_TRACE_DUMP()                                                                           \
+    do {                                                                                           \
+    } while (0)
+#define RMB_TRACE_SHUTDOWN()                                                                       \
+    do {                                                                                           \
+    } while (0)
+#endif
\ No newline at end of file
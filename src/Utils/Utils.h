@@ -1,5 +1,7 @@
 #pragma once
 
+#include <chrono>
+#include <cstdint>
 #include <string>
 #include <vector>
 
@@ -29,4 +31,10 @@ template <typename T>
 inline int sign(T val) {
     return (T(0) < val) - (val < T(0));
 }
+/* monotonic timestamp, used for measuring latencies across threads */
+inline uint64_t now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+               std::chrono::steady_clock::now().time_since_epoch())
+        .count();
+}
 } // namespace Utils
\ No newline at end of file
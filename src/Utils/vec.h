@@ -1,3 +1,4 @@
+#pragma once
 #include <cmath>
 #include <stdint.h>
 // https://github.com/OneLoneCoder/olcPixelGameEngine/blob/master/olcPixelGameEngine.h
@@ -0,0 +1,290 @@
+#include "input_trace.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <thread>
+
+#include "Utils.h"
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+static constexpr char TRACE_MAGIC[8] = {'R', 'M', 'B', 'T', 'R', 'A', 'C', 'E'};
+
+bool InputTraceWriter::Start(const std::string& file) {
+    if (Current()) {
+        return false;
+    }
+
+    auto writer = new InputTraceWriter();
+    if (!writer->Open(file)) {
+        delete writer;
+        return false;
+    }
+    current_.store(writer, std::memory_order_release);
+    fprintf(stdout, "Recording input trace to %s\n", file.c_str());
+    return true;
+}
+
+void InputTraceWriter::Stop() {
+    InputTraceWriter* writer = current_.exchange(nullptr);
+    if (!writer) {
+        return;
+    }
+    while (appending_.load() != 0) {
+        std::this_thread::yield();
+    }
+    delete writer;
+}
+
+/* the capture points only pay for an atomic load while nothing is recorded */
+void InputTraceWriter::AddMouseDelta(float dx, float dy) {
+    if (!Current()) {
+        return;
+    }
+    InputTraceRecord record{};
+    record.type = InputTraceType::MouseDelta;
+    record.dx = dx;
+    record.dy = dy;
+    appending_.fetch_add(1);
+    if (InputTraceWriter* writer = current_.load()) {
+        writer->Append(record);
+    }
+    appending_.fetch_sub(1);
+}
+
+void InputTraceWriter::AddMouseButton(uint32_t button, bool is_pressed) {
+    if (!Current()) {
+        return;
+    }
+    InputTraceRecord record{};
+    record.type = InputTraceType::MouseButton;
+    record.code = button;
+    record.is_pressed = is_pressed;
+    appending_.fetch_add(1);
+    if (InputTraceWriter* writer = current_.load()) {
+        writer->Append(record);
+    }
+    appending_.fetch_sub(1);
+}
+
+void InputTraceWriter::AddKeys(const KeysBitset& keys, bool is_down) {
+    if (!Current() || keys.none()) {
+        return;
+    }
+    InputTraceRecord record{};
+    record.type = is_down ? InputTraceType::KeyDown : InputTraceType::KeyUp;
+    appending_.fetch_add(1);
+    if (InputTraceWriter* writer = current_.load()) {
+        for (uint32_t i = 0; i < MAX_KEYBOARD_SCAN_CODE; i++) {
+            if (keys[i]) {
+                record.code = i;
+                writer->Append(record);
+            }
+        }
+    }
+    appending_.fetch_sub(1);
+}
+
+void InputTraceWriter::AddKeys(const uint32_t* keys, size_t count, bool is_down) {
+    if (!Current() || count == 0) {
+        return;
+    }
+    InputTraceRecord record{};
+    record.type = is_down ? InputTraceType::KeyDown : InputTraceType::KeyUp;
+    appending_.fetch_add(1);
+    if (InputTraceWriter* writer = current_.load()) {
+        for (size_t i = 0; i < count; i++) {
+            record.code = keys[i];
+            writer->Append(record);
+        }
+    }
+    appending_.fetch_sub(1);
+}
+
+void InputTraceWriter::Append(InputTraceRecord record) {
+    record.time_ns = Utils::now_ns() - start_ns_;
+    const size_t offset = used_.fetch_add(sizeof(InputTraceRecord), std::memory_order_relaxed);
+    if (offset + sizeof(InputTraceRecord) > capacity_) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    memcpy(map_ + sizeof(InputTraceHeader) + offset, &record, sizeof(record));
+}
+
+bool InputTraceWriter::Open(const std::string& file) {
+    const size_t size = sizeof(InputTraceHeader) + CAPACITY;
+#ifdef _WIN32
+    file_ = CreateFileA(file.c_str(), GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, nullptr,
+                        CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file_ == INVALID_HANDLE_VALUE) {
+        file_ = nullptr;
+        fprintf(stderr, "Couldn't create input trace: %s\n", file.c_str());
+        return false;
+    }
+    mapping_ = CreateFileMappingA(file_, nullptr, PAGE_READWRITE, static_cast<DWORD>(size >> 32),
+                                  static_cast<DWORD>(size), nullptr);
+    if (mapping_) {
+        map_ = static_cast<unsigned char*>(MapViewOfFile(mapping_, FILE_MAP_WRITE, 0, 0, size));
+    }
+#else
+    fd_ = open(file.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (fd_ < 0) {
+        fprintf(stderr, "Couldn't create input trace: %s\n", file.c_str());
+        return false;
+    }
+    if (ftruncate(fd_, static_cast<off_t>(size)) == 0) {
+        void* map = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+        map_ = map == MAP_FAILED ? nullptr : static_cast<unsigned char*>(map);
+    }
+#endif
+    if (!map_) {
+        fprintf(stderr, "Couldn't map input trace: %s\n", file.c_str());
+        return false;
+    }
+
+    capacity_ = CAPACITY;
+    start_ns_ = Utils::now_ns();
+
+    InputTraceHeader header{};
+    memcpy(header.magic, TRACE_MAGIC, sizeof(header.magic));
+    header.version = VERSION;
+    header.record_size = sizeof(InputTraceRecord);
+    header.start_ns = start_ns_;
+    memcpy(map_, &header, sizeof(header));
+    return true;
+}
+
+InputTraceWriter::~InputTraceWriter() {
+    const size_t used = std::min(used_.load(), capacity_);
+    const size_t size = sizeof(InputTraceHeader) + used;
+    if (map_) {
+        const uint64_t record_count = used / sizeof(InputTraceRecord);
+        memcpy(map_ + offsetof(InputTraceHeader, record_count), &record_count,
+               sizeof(record_count));
+        if (dropped_.load()) {
+            fprintf(stderr, "Input trace full, dropped %zu records\n", dropped_.load());
+        }
+    }
+#ifdef _WIN32
+    if (map_)
+        UnmapViewOfFile(map_);
+    if (mapping_)
+        CloseHandle(mapping_);
+    if (file_) {
+        LARGE_INTEGER end;
+        end.QuadPart = static_cast<LONGLONG>(size);
+        SetFilePointerEx(file_, end, nullptr, FILE_BEGIN);
+        SetEndOfFile(file_);
+        CloseHandle(file_);
+    }
+#else
+    if (map_)
+        munmap(map_, sizeof(InputTraceHeader) + capacity_);
+    if (fd_ >= 0) {
+        if (map_ && ftruncate(fd_, static_cast<off_t>(size)) != 0) {
+            fprintf(stderr, "Couldn't truncate the input trace\n");
+        }
+        close(fd_);
+    }
+#endif
+}
+
+InputTraceReader::~InputTraceReader() {
+    Close();
+}
+
+bool InputTraceReader::Open(const std::string& file) {
+    Close();
+#ifdef _WIN32
+    file_ = CreateFileA(file.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE, nullptr,
+                        OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file_ == INVALID_HANDLE_VALUE) {
+        file_ = nullptr;
+        fprintf(stderr, "Couldn't open input trace: %s\n", file.c_str());
+        return false;
+    }
+    LARGE_INTEGER file_size;
+    if (GetFileSizeEx(file_, &file_size)) {
+        size_ = static_cast<size_t>(file_size.QuadPart);
+        mapping_ = CreateFileMappingA(file_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    }
+    if (mapping_) {
+        map_ = static_cast<const unsigned char*>(MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0));
+    }
+#else
+    fd_ = open(file.c_str(), O_RDONLY);
+    if (fd_ < 0) {
+        fprintf(stderr, "Couldn't open input trace: %s\n", file.c_str());
+        return false;
+    }
+    struct stat file_stat {};
+    if (fstat(fd_, &file_stat) == 0 && file_stat.st_size > 0) {
+        size_ = static_cast<size_t>(file_stat.st_size);
+        void* map = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd_, 0);
+        map_ = map == MAP_FAILED ? nullptr : static_cast<const unsigned char*>(map);
+    }
+#endif
+    if (!map_ || size_ < sizeof(InputTraceHeader)) {
+        fprintf(stderr, "Couldn't map input trace: %s\n", file.c_str());
+        Close();
+        return false;
+    }
+
+    InputTraceHeader header;
+    memcpy(&header, map_, sizeof(header));
+    if (memcmp(header.magic, TRACE_MAGIC, sizeof(header.magic)) != 0 ||
+        header.version != InputTraceWriter::VERSION ||
+        header.record_size != sizeof(InputTraceRecord)) {
+        fprintf(stderr, "Not a supported input trace: %s\n", file.c_str());
+        Close();
+        return false;
+    }
+
+    records_ = reinterpret_cast<const InputTraceRecord*>(map_ + sizeof(InputTraceHeader));
+    count_ = (size_ - sizeof(InputTraceHeader)) / sizeof(InputTraceRecord);
+    if (header.record_count) {
+        count_ = std::min<size_t>(count_, header.record_count);
+    }
+    else {
+        /* the recording wasn't stopped, the rest of the sparse file is zeroed */
+        static constexpr InputTraceRecord empty{};
+        for (size_t i = 0; i < count_; i++) {
+            if (memcmp(&records_[i], &empty, sizeof(empty)) == 0) {
+                count_ = i;
+                break;
+            }
+        }
+    }
+    return true;
+}
+
+void InputTraceReader::Close() {
+#ifdef _WIN32
+    if (map_)
+        UnmapViewOfFile(map_);
+    if (mapping_)
+        CloseHandle(mapping_);
+    if (file_)
+        CloseHandle(file_);
+    mapping_ = nullptr;
+    file_ = nullptr;
+#else
+    if (map_)
+        munmap(const_cast<unsigned char*>(map_), size_);
+    if (fd_ >= 0)
+        close(fd_);
+    fd_ = -1;
+#endif
+    map_ = nullptr;
+    size_ = 0;
+    records_ = nullptr;
+    count_ = 0;
+}
\ No newline at end of file
@@ -0,0 +1,115 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "native.h"
+
+/* Binary input trace: `InputTraceHeader` followed by `InputTraceRecord`s in the order they were
+ * appended, little endian, written through a memory mapped file. */
+enum class InputTraceType : uint8_t {
+    MouseDelta,
+    MouseButton,
+    KeyDown,
+    KeyUp,
+};
+
+struct InputTraceHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t record_size;
+    /* written when the recording is stopped, 0 if it never was */
+    uint64_t record_count;
+    uint64_t start_ns;
+};
+
+struct InputTraceRecord {
+    /* since `InputTraceHeader::start_ns` */
+    uint64_t time_ns;
+    /* `MouseButton`: one of the `MOUSE_*BUTTON`s, `KeyDown/Up`: scan code */
+    uint32_t code;
+    InputTraceType type;
+    uint8_t is_pressed;
+    uint16_t reserved;
+    /* `MouseDelta`: pointer movement */
+    float dx;
+    float dy;
+};
+
+static_assert(sizeof(InputTraceHeader) == 32);
+static_assert(sizeof(InputTraceRecord) == 24);
+
+class InputTraceWriter {
+public:
+    static constexpr uint32_t VERSION = 1;
+    /* the file is sparse until written, ~45 minutes of 1000 events per second */
+    static constexpr size_t CAPACITY = 64ull * 1024 * 1024;
+
+    /* the writer every capture point appends to, nullptr while not recording */
+    static InputTraceWriter* Current() {
+        return current_.load(std::memory_order_acquire);
+    }
+    static bool Start(const std::string& file);
+    /* waits for the appends in flight and truncates the file to the recorded size */
+    static void Stop();
+
+    static void AddMouseDelta(float dx, float dy);
+    static void AddMouseButton(uint32_t button, bool is_pressed);
+    static void AddKeys(const KeysBitset& keys, bool is_down);
+    static void AddKeys(const uint32_t* keys, size_t count, bool is_down);
+
+private:
+    InputTraceWriter() = default;
+    ~InputTraceWriter();
+
+    bool Open(const std::string& file);
+    void Append(InputTraceRecord record);
+
+    inline static std::atomic<InputTraceWriter*> current_ = nullptr;
+    inline static std::atomic_int appending_ = 0;
+
+    unsigned char* map_ = nullptr;
+    size_t capacity_ = 0;
+    std::atomic_size_t used_ = 0;
+    std::atomic_size_t dropped_ = 0;
+    uint64_t start_ns_ = 0;
+#ifdef _WIN32
+    void* file_ = nullptr;
+    void* mapping_ = nullptr;
+#else
+    int fd_ = -1;
+#endif
+};
+
+class InputTraceReader {
+public:
+    InputTraceReader() = default;
+    ~InputTraceReader();
+
+    InputTraceReader(const InputTraceReader&) = delete;
+    InputTraceReader& operator=(const InputTraceReader&) = delete;
+
+    bool Open(const std::string& file);
+
+    const InputTraceRecord* GetRecords() const {
+        return records_;
+    }
+    size_t GetCount() const {
+        return count_;
+    }
+
+private:
+    void Close();
+
+    const unsigned char* map_ = nullptr;
+    size_t size_ = 0;
+    const InputTraceRecord* records_ = nullptr;
+    size_t count_ = 0;
+#ifdef _WIN32
+    void* file_ = nullptr;
+    void* mapping_ = nullptr;
+#else
+    int fd_ = -1;
+#endif
+};
\ No newline at end of file
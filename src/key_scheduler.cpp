@@ -0,0 +1,401 @@
+#include "key_scheduler.h"
+
+#include <algorithm>
+#include "input_trace.h"
+#include "native.h"
+#include "thread_priority.h"
+
+std::shared_ptr<KeyScheduler> KeyScheduler::GetInstance() {
+    static std::shared_ptr<KeyScheduler> singleton_(new KeyScheduler());
+    return singleton_;
+}
+
+/* the keys the scheduler presses on its own thread show up in the input trace too */
+static void SendKeys(uint32_t* keys, size_t count, bool is_down) {
+    if (is_down)
+        Native::GetInstance()->SendKeysDown(keys, count);
+    else
+        Native::GetInstance()->SendKeysUp(keys, count);
+    InputTraceWriter::AddKeys(keys, count, is_down);
+}
+
+KeyScheduler::KeyScheduler() {
+    update_thread_ = std::jthread([this](std::stop_token stop_token) { UpdateThread(stop_token); });
+}
+
+KeyScheduler::~KeyScheduler() {
+    update_thread_.request_stop();
+}
+
+void KeyScheduler::SetDuty(uint32_t key, float duty) {
+    duty = std::clamp(duty, 0.f, 1.f);
+
+    std::scoped_lock<std::mutex> lock{mutex_};
+    Channel* channel = nullptr;
+    for (size_t i = 0; i < channels_count_; i++) {
+        if (channels_[i].key == key) {
+            channel = &channels_[i];
+            break;
+        }
+    }
+    if (!channel) {
+        if (duty == 0.f || channels_count_ >= max_channels)
+            return;
+        channel = &channels_[channels_count_++];
+        *channel = {key, 0.f, false, {}};
+    }
+    if (channel->duty == duty)
+        return;
+
+    channel->duty = duty;
+    changed_ = true;
+    cv_.notify_one();
+}
+
+void KeyScheduler::SetPeriod(std::chrono::microseconds period) {
+    std::scoped_lock<std::mutex> lock{mutex_};
+    period_ = std::max(period, std::chrono::microseconds(1000));
+    changed_ = true;
+    cv_.notify_one();
+}
+
+void KeyScheduler::Tap(uint32_t code, std::chrono::microseconds duration, TapSink sink,
+                       void* context) {
+    std::scoped_lock<std::mutex> lock{mutex_};
+    for (size_t i = 0; i < taps_count_; i++) {
+        PendingTap& tap = taps_[i];
+        if (tap.code == code && tap.sink == sink && tap.context == context) {
+            tap.queued++;
+            return;
+        }
+    }
+    if (taps_count_ >= max_taps)
+        return;
+
+    taps_[taps_count_++] = {code, sink, context, duration, 1, false, Clock::now()};
+    changed_ = true;
+    cv_.notify_one();
+}
+
+void KeyScheduler::CancelTaps(void* context) {
+    std::unique_lock<std::mutex> lock{mutex_};
+    size_t active_count = 0;
+    for (size_t i = 0; i < taps_count_; i++) {
+        if (taps_[i].context != context)
+            taps_[active_count++] = taps_[i];
+    }
+    taps_count_ = active_count;
+    cv_.wait(lock, [this] { return !sending_taps_; });
+}
+
+void KeyScheduler::PlayMacro(uint32_t id, const MacroEvent* events, size_t count,
+                             std::chrono::microseconds repeat) {
+    count = std::min(count, MAX_MACRO_EVENTS);
+    if (count == 0)
+        return;
+
+    std::scoped_lock<std::mutex> lock{mutex_};
+    Macro* free_macro = nullptr;
+    for (Macro& macro : macros_) {
+        if (macro.playing && macro.id == id)
+            return;
+        if (!macro.playing && !free_macro)
+            free_macro = &macro;
+    }
+    if (!free_macro)
+        return;
+
+    Macro& macro = *free_macro;
+    macro.id = id;
+    macro.playing = true;
+    std::copy(events, events + count, macro.events);
+    macro.events_count = count;
+    macro.next_event = 0;
+    macro.repeat = repeat;
+    macro.started_at = Clock::now();
+    macro.held_count = 0;
+    PushDeadline(static_cast<size_t>(&macro - macros_));
+    changed_ = true;
+    cv_.notify_one();
+}
+
+void KeyScheduler::StopMacro(uint32_t id) {
+    std::scoped_lock<std::mutex> lock{mutex_};
+    for (size_t i = 0; i < max_macros; i++) {
+        if (macros_[i].playing && macros_[i].id == id)
+            EndMacro(i);
+    }
+}
+
+void KeyScheduler::ReleaseChannels() {
+    std::scoped_lock<std::mutex> lock{mutex_};
+    for (size_t i = 0; i < channels_count_; i++) {
+        channels_[i].duty = 0.f;
+    }
+    changed_ = true;
+    cv_.notify_one();
+}
+
+void KeyScheduler::Clear() {
+    std::scoped_lock<std::mutex> lock{mutex_};
+    for (size_t i = 0; i < channels_count_; i++) {
+        channels_[i].duty = 0.f;
+    }
+    const auto now = Clock::now();
+    for (size_t i = 0; i < taps_count_; i++) {
+        taps_[i].queued = 0;
+        if (taps_[i].is_down)
+            taps_[i].next_at = now;
+    }
+    for (size_t i = 0; i < max_macros; i++) {
+        if (macros_[i].playing)
+            EndMacro(i);
+    }
+    changed_ = true;
+    cv_.notify_one();
+}
+
+bool KeyScheduler::AnyActive() const {
+    for (size_t i = 0; i < channels_count_; i++) {
+        if (channels_[i].duty > 0.f || channels_[i].is_down)
+            return true;
+    }
+    return taps_count_ != 0 || deadlines_count_ != 0;
+}
+
+bool KeyScheduler::IsLater(const MacroDeadline& a, const MacroDeadline& b) {
+    return a.at > b.at;
+}
+
+KeyScheduler::Clock::time_point KeyScheduler::UpdateTaps(Clock::time_point now, PendingTap* due,
+                                                         size_t* due_count) {
+    auto next_deadline = Clock::time_point::max();
+    size_t active_count = 0;
+    for (size_t i = 0; i < taps_count_; i++) {
+        PendingTap& tap = taps_[i];
+        if (tap.next_at <= now) {
+            /* released and nothing queued behind it */
+            if (!tap.is_down && tap.queued == 0)
+                continue;
+
+            tap.is_down = !tap.is_down;
+            tap.queued -= tap.is_down;
+            /* released for as long as it was held, or the game may miss the next press */
+            tap.next_at = now + tap.duration;
+            due[(*due_count)++] = tap;
+        }
+        next_deadline = std::min(next_deadline, tap.next_at);
+        taps_[active_count++] = tap;
+    }
+    taps_count_ = active_count;
+    return next_deadline;
+}
+
+void KeyScheduler::SendTaps(const PendingTap* taps, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        uint32_t code = taps[i].code;
+        if (taps[i].sink)
+            taps[i].sink(taps[i].context, code, taps[i].is_down);
+        else
+            SendKeys(&code, 1, taps[i].is_down);
+    }
+}
+
+void KeyScheduler::PushDeadline(size_t index) {
+    const Macro& macro = macros_[index];
+    deadlines_[deadlines_count_++] = {
+        macro.started_at + macro.events[macro.next_event].offset, index};
+    std::push_heap(deadlines_, deadlines_ + deadlines_count_, IsLater);
+}
+
+void KeyScheduler::EndMacro(size_t index) {
+    Macro& macro = macros_[index];
+    if (macro.held_count)
+        SendKeys(macro.held, macro.held_count, false);
+    macro.held_count = 0;
+    macro.playing = false;
+
+    for (size_t i = 0; i < deadlines_count_; i++) {
+        if (deadlines_[i].macro == index) {
+            deadlines_[i] = deadlines_[--deadlines_count_];
+            std::make_heap(deadlines_, deadlines_ + deadlines_count_, IsLater);
+            break;
+        }
+    }
+}
+
+void KeyScheduler::SendMacroEvent(Macro& macro, const MacroEvent& event) {
+    uint32_t key = event.key;
+    uint32_t* held_end = macro.held + macro.held_count;
+    uint32_t* held = std::find(macro.held, held_end, key);
+    if (event.is_down) {
+        if (held == held_end)
+            macro.held[macro.held_count++] = key;
+        SendKeys(&key, 1, true);
+    }
+    else {
+        if (held != held_end)
+            *held = macro.held[--macro.held_count];
+        SendKeys(&key, 1, false);
+    }
+}
+
+KeyScheduler::Clock::time_point KeyScheduler::UpdateMacros(Clock::time_point now) {
+    while (deadlines_count_ && deadlines_[0].at <= now) {
+        std::pop_heap(deadlines_, deadlines_ + deadlines_count_, IsLater);
+        const size_t index = deadlines_[--deadlines_count_].macro;
+        Macro& macro = macros_[index];
+        SendMacroEvent(macro, macro.events[macro.next_event]);
+
+        if (++macro.next_event == macro.events_count) {
+            /* whatever the steps left pressed goes up with the end of the macro */
+            if (macro.repeat.count() == 0) {
+                EndMacro(index);
+                continue;
+            }
+            macro.next_event = 0;
+            macro.started_at += macro.repeat;
+            /* only a stall longer than a whole round moves the phase */
+            if (now - macro.started_at >= macro.repeat)
+                macro.started_at = now;
+        }
+        PushDeadline(index);
+    }
+    return deadlines_count_ ? deadlines_[0].at : Clock::time_point::max();
+}
+
+void KeyScheduler::ScheduleRelease(Channel& channel, Clock::time_point period_start) {
+    /* fully pushed, nothing to release till the duty changes */
+    if (channel.duty >= 1.f) {
+        channel.release_at = Clock::time_point::max();
+        return;
+    }
+    channel.release_at =
+        period_start + std::chrono::duration_cast<Clock::duration>(period_ * channel.duty);
+}
+
+void KeyScheduler::UpdateThread(std::stop_token stop_token) {
+    ThreadPriority::Scope priority("KeyScheduler");
+    uint32_t keys[max_channels]{};
+    size_t keys_count = 0;
+    PendingTap due[max_taps]{};
+
+    Clock::time_point next_period_start{};
+
+    std::unique_lock<std::mutex> lock{mutex_};
+    while (!stop_token.stop_requested()) {
+        /* sleeps without any timeout while nothing is being pulsed */
+        if (!cv_.wait(lock, stop_token, [this] { return AnyActive(); }))
+            break;
+
+        /* periods follow each other back to back, only restart the phase after being idle */
+        const auto woke_at = Clock::now();
+        const auto period_start =
+            woke_at - next_period_start < period_ ? next_period_start : woke_at;
+        const auto period_end = period_start + period_;
+        next_period_start = period_end;
+
+        keys_count = 0;
+        for (size_t i = 0; i < channels_count_; i++) {
+            Channel& channel = channels_[i];
+            if (channel.duty > 0.f) {
+                ScheduleRelease(channel, period_start);
+                if (!channel.is_down) {
+                    keys[keys_count++] = channel.key;
+                    channel.is_down = true;
+                }
+            }
+        }
+        if (keys_count)
+            SendKeys(keys, keys_count, true);
+
+        while (!stop_token.stop_requested()) {
+            auto now = Clock::now();
+            if (changed_) {
+                changed_ = false;
+                keys_count = 0;
+                for (size_t i = 0; i < channels_count_; i++) {
+                    Channel& channel = channels_[i];
+                    ScheduleRelease(channel, period_start);
+                    /* a key whose duty grew past the elapsed time goes down right away */
+                    if (!channel.is_down && channel.duty > 0.f && channel.release_at > now) {
+                        keys[keys_count++] = channel.key;
+                        channel.is_down = true;
+                    }
+                }
+                if (keys_count)
+                    SendKeys(keys, keys_count, true);
+            }
+
+            keys_count = 0;
+            auto next_deadline = period_end;
+            for (size_t i = 0; i < channels_count_; i++) {
+                Channel& channel = channels_[i];
+                if (!channel.is_down)
+                    continue;
+                if (channel.duty == 0.f || channel.release_at <= now) {
+                    keys[keys_count++] = channel.key;
+                    channel.is_down = false;
+                }
+                else {
+                    next_deadline = std::min(next_deadline, channel.release_at);
+                }
+            }
+            if (keys_count)
+                SendKeys(keys, keys_count, false);
+            next_deadline = std::min(next_deadline, UpdateMacros(now));
+            size_t due_count = 0;
+            next_deadline = std::min(next_deadline, UpdateTaps(now, due, &due_count));
+            if (due_count) {
+                /* a sink may lock something which is held while calling into the scheduler */
+                sending_taps_ = true;
+                lock.unlock();
+                SendTaps(due, due_count);
+                lock.lock();
+                sending_taps_ = false;
+                cv_.notify_all();
+            }
+
+            if (now >= period_end)
+                break;
+            /* absolute deadline, so the on-time doesn't stretch by however long the sends took */
+            cv_.wait_until(lock, stop_token, next_deadline, [this] { return changed_; });
+        }
+
+        /* forget the channels which were released for good */
+        size_t active_count = 0;
+        for (size_t i = 0; i < channels_count_; i++) {
+            if (channels_[i].duty > 0.f || channels_[i].is_down)
+                channels_[active_count++] = channels_[i];
+        }
+        channels_count_ = active_count;
+    }
+
+    keys_count = 0;
+    for (size_t i = 0; i < channels_count_; i++) {
+        if (channels_[i].is_down)
+            keys[keys_count++] = channels_[i].key;
+    }
+    if (keys_count)
+        SendKeys(keys, keys_count, false);
+    for (size_t i = 0; i < max_macros; i++) {
+        if (macros_[i].playing)
+            EndMacro(i);
+    }
+
+    size_t due_count = 0;
+    for (size_t i = 0; i < taps_count_; i++) {
+        if (taps_[i].is_down) {
+            due[due_count] = taps_[i];
+            due[due_count++].is_down = false;
+        }
+    }
+    taps_count_ = 0;
+    sending_taps_ = true;
+    lock.unlock();
+    SendTaps(due, due_count);
+    lock.lock();
+    sending_taps_ = false;
+    cv_.notify_all();
+    fprintf(stdout, "Exiting key scheduler...\n");
+}
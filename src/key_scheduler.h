@@ -0,0 +1,136 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+/* Presses and releases keys on precise deadlines. Every key with a duty cycle is pressed at the start
+ * of each period and released after `duty * period`, which lets a keyboard binding express how far the
+ * stick is pushed. Macros are played by the same thread, their next steps are kept in a min-heap of
+ * absolute deadlines. */
+class KeyScheduler {
+public:
+    static constexpr size_t MAX_MACRO_EVENTS = 32;
+
+    /* a press or release of `PlayMacro`, `offset` after the macro started */
+    struct MacroEvent {
+        std::chrono::microseconds offset;
+        uint32_t key;
+        bool is_down;
+    };
+
+    /* receives the presses and releases of a `Tap` with its `context`, the keys go to `Native`
+     * without one */
+    using TapSink = void (*)(void* context, uint32_t code, bool is_down);
+
+    static std::shared_ptr<KeyScheduler> GetInstance();
+
+    KeyScheduler();
+    ~KeyScheduler();
+
+    KeyScheduler(const KeyScheduler&) = delete;
+    KeyScheduler& operator=(const KeyScheduler&) = delete;
+
+    /* [0, 1], 0 releases the key and 1 keeps it held */
+    void SetDuty(uint32_t key, float duty);
+    void SetPeriod(std::chrono::microseconds period);
+    /* presses `code` and releases it `duration` later without blocking the caller. the taps of
+     * the same code queue up, each one is released and pressed again after the same duration */
+    void Tap(uint32_t code, std::chrono::microseconds duration, TapSink sink = nullptr,
+             void* context = nullptr);
+    /* drops the taps with `context` without sending the rest of them, once it returns their
+     * sinks aren't called anymore */
+    void CancelTaps(void* context);
+    /* plays `events`, sorted by offset, from now on. with a `repeat` period they start over every
+     * period, counted from when the last round started so they don't drift, till `StopMacro`.
+     * a macro whose `id` is already playing isn't started again */
+    void PlayMacro(uint32_t id, const MacroEvent* events, size_t count,
+                   std::chrono::microseconds repeat = std::chrono::microseconds(0));
+    /* drops the rest of the macro and releases the keys it holds */
+    void StopMacro(uint32_t id);
+    /* releases the keys of `SetDuty`, the taps and macros keep going */
+    void ReleaseChannels();
+    /* releases every key this scheduler pressed, the taps and macros end too */
+    void Clear();
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Channel {
+        uint32_t key;
+        float duty;
+        bool is_down;
+        Clock::time_point release_at;
+    };
+
+    struct PendingTap {
+        uint32_t code;
+        TapSink sink;
+        void* context;
+        std::chrono::microseconds duration;
+        /* taps still to be pressed after the current one */
+        uint32_t queued;
+        bool is_down;
+        /* next press or release, or when it may be pressed again */
+        Clock::time_point next_at;
+    };
+
+    struct Macro {
+        uint32_t id;
+        bool playing;
+        MacroEvent events[MAX_MACRO_EVENTS];
+        size_t events_count;
+        size_t next_event;
+        std::chrono::microseconds repeat;
+        /* start of the current round */
+        Clock::time_point started_at;
+        uint32_t held[MAX_MACRO_EVENTS];
+        size_t held_count;
+    };
+
+    struct MacroDeadline {
+        Clock::time_point at;
+        size_t macro;
+    };
+
+    static constexpr size_t max_channels = 8;
+    static constexpr size_t max_taps = 8;
+    static constexpr size_t max_macros = 8;
+
+    void UpdateThread(std::stop_token stop_token);
+    bool AnyActive() const;
+    void ScheduleRelease(Channel& channel, Clock::time_point period_start);
+    /* copies the taps which flip now into `due` and returns the earliest next deadline, the
+     * finished taps are dropped */
+    Clock::time_point UpdateTaps(Clock::time_point now, PendingTap* due, size_t* due_count);
+    /* without the lock held */
+    static void SendTaps(const PendingTap* taps, size_t count);
+    /* sends the macro events which are due and returns the earliest next deadline */
+    Clock::time_point UpdateMacros(Clock::time_point now);
+    static void SendMacroEvent(Macro& macro, const MacroEvent& event);
+    /* releases the held keys and takes the macro's deadline off the heap */
+    void EndMacro(size_t index);
+    void PushDeadline(size_t index);
+    /* heap order, the earliest deadline is at the front */
+    static bool IsLater(const MacroDeadline& a, const MacroDeadline& b);
+
+    Channel channels_[max_channels]{};
+    size_t channels_count_ = 0;
+    PendingTap taps_[max_taps]{};
+    size_t taps_count_ = 0;
+    Macro macros_[max_macros]{};
+    /* one per playing macro, the earliest one first */
+    MacroDeadline deadlines_[max_macros]{};
+    size_t deadlines_count_ = 0;
+    std::chrono::microseconds period_{8000};
+    bool changed_ = false;
+    /* the taps are sent without the lock */
+    bool sending_taps_ = false;
+
+    std::mutex mutex_;
+    std::condition_variable_any cv_;
+    std::jthread update_thread_;
+};
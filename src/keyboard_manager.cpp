@@ -1,16 +1,27 @@
 #include "keyboard_manager.h"
+#include "input_trace.h"
+#include "thread_priority.h"
 
 #ifndef _WIN32
 #include <string.h>
 #endif
 
+static bool manual_update_ = false;
+
 std::shared_ptr<KeyboardManager> KeyboardManager::GetInstance() {
-    static std::shared_ptr<KeyboardManager> singleton_(new KeyboardManager());
+    static std::shared_ptr<KeyboardManager> singleton_(new KeyboardManager(!manual_update_));
     return singleton_;
 }
 
-KeyboardManager::KeyboardManager() {
-    update_thread_ = std::jthread([this](std::stop_token stop_token) { UpdateThread(stop_token); });
+void KeyboardManager::UseManualUpdate() {
+    manual_update_ = true;
+}
+
+KeyboardManager::KeyboardManager(bool threaded) {
+    if (threaded) {
+        update_thread_ =
+            std::jthread([this](std::stop_token stop_token) { UpdateThread(stop_token); });
+    }
 }
 
 KeyboardManager::~KeyboardManager() {
@@ -25,50 +36,68 @@ void KeyboardManager::Clear() {
     clear_requested_.store(true, std::memory_order_release);
 }
 
-void KeyboardManager::UpdateThread(std::stop_token stop_token) {
+void KeyboardManager::Update() {
     constexpr int max_dequeue_items = 4 * 2;
     KeysBitset keys[max_dequeue_items]{};
+    size_t keys_cnt = 0;
 
-    while (!stop_token.stop_requested()) {
-        size_t keys_cnt = 0;
+    if (clear_requested_.load(std::memory_order_acquire)) {
+        ClearDownKeys();
+        return;
+    }
 
-        if (clear_requested_.load(std::memory_order_acquire)) {
-            ClearDownKeys();
-            goto end_frame;
-        }
-        {
-            bool sent_updates = false;
-            do {
-                keys_cnt = down_keys_queue_.try_dequeue_bulk(keys, max_dequeue_items);
-                if (keys_cnt) {
-                    for (size_t i = 0; i < keys_cnt; i++) {
-                        Native::GetInstance()->SendKeysBitsetDown(keys[i]);
-                        down_keys_in_ |= keys[i];
-                    }
-                    sent_updates = true;
-                }
-            } while (keys_cnt != 0);
-
-            do {
-                keys_cnt = up_keys_queue_.try_dequeue_bulk(keys, max_dequeue_items);
-                if (keys_cnt) {
-                    for (size_t i = 0; i < keys_cnt; i++) {
-                        Native::GetInstance()->SendKeysBitsetUp(keys[i]);
-                        down_keys_in_ &= ~(keys[i]);
-                    }
-                }
-            } while (keys_cnt != 0);
-
-            if (sent_updates)
-                goto end_frame;
+    /* everything queued since the last frame is merged into one net diff, the stick handler
+     * re-releases keys which are already up on every change */
+    KeysBitset queued_down{};
+    KeysBitset queued_up{};
+    do {
+        keys_cnt = down_keys_queue_.try_dequeue_bulk(keys, max_dequeue_items);
+        for (size_t i = 0; i < keys_cnt; i++) {
+            queued_down |= keys[i];
         }
+    } while (keys_cnt != 0);
 
-        if (persistent_mode_.load(std::memory_order_acquire)) {
-            Native::GetInstance()->SendKeysBitsetDown(down_keys_in_);
+    do {
+        keys_cnt = up_keys_queue_.try_dequeue_bulk(keys, max_dequeue_items);
+        for (size_t i = 0; i < keys_cnt; i++) {
+            queued_up |= keys[i];
         }
+    } while (keys_cnt != 0);
+
+    /* downs are applied before ups like before, a key pressed and released within the same frame
+     * still gets tapped */
+    const KeysBitset new_down = queued_down & ~down_keys_in_;
+    const KeysBitset new_up = queued_up & (down_keys_in_ | queued_down);
+    down_keys_in_ = (down_keys_in_ | queued_down) & ~queued_up;
+
+    if (new_down.any()) {
+        RMB_TRACE_SCOPE("KeysDown");
+        Native::GetInstance()->SendKeysBitsetDown(new_down);
+        InputTraceWriter::AddKeys(new_down, true);
+        RMB_TRACE_END(KeysSent);
+    }
+    if (new_up.any()) {
+        RMB_TRACE_SCOPE("KeysUp");
+        Native::GetInstance()->SendKeysBitsetUp(new_up);
+        InputTraceWriter::AddKeys(new_up, false);
+        RMB_TRACE_END(KeysSent);
+    }
 
-    end_frame:
-        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    if (queued_down.any())
+        return;
+
+    if (persistent_mode_.load(std::memory_order_acquire)) {
+        RMB_TRACE_SCOPE("KeysPersist");
+        Native::GetInstance()->SendKeysBitsetDown(down_keys_in_);
+    }
+}
+
+void KeyboardManager::UpdateThread(std::stop_token stop_token) {
+    RMB_TRACE_THREAD("KeyboardManager");
+    ThreadPriority::Scope priority("KeyboardManager");
+    while (!stop_token.stop_requested()) {
+        Update();
+        std::this_thread::sleep_for(UPDATE_PERIOD);
     }
     ClearDownKeys();
     fprintf(stdout, "Exiting keyboard manager...\n");
@@ -1,32 +1,48 @@
 #pragma once
 
 #include "native.h"
+#include "Tracer.h"
 #include "concurrentqueue.h"
 
+#include <chrono>
+
 class KeyboardManager {
 public:
+    static constexpr std::chrono::milliseconds UPDATE_PERIOD{1};
+
     static std::shared_ptr<KeyboardManager> GetInstance();
+    /* has to be called before the first `GetInstance`, the instance won't start its own thread and
+     * the owner has to call `Update` after queueing keys, and every `UPDATE_PERIOD` in persistent
+     * mode */
+    static void UseManualUpdate();
 
-    KeyboardManager();
+    explicit KeyboardManager(bool threaded = true);
     ~KeyboardManager();
 
+    /* sends the queued keys, one frame of the update thread */
+    void Update();
+
     inline void SendKeysDown(KeysBitset keys) {
+        RMB_TRACE_STAMP(KeyQueued);
         down_keys_queue_.enqueue(keys);
     }
 
     inline void SendKeysUp(KeysBitset keys) {
+        RMB_TRACE_STAMP(KeyQueued);
         up_keys_queue_.enqueue(keys);
     }
 
     inline void SendKeyDown(uint32_t key) {
         KeysBitset current_set{};
         current_set.set(key);
+        RMB_TRACE_STAMP(KeyQueued);
         down_keys_queue_.enqueue(current_set);
     }
 
     inline void SendKeyUp(uint32_t key) {
         KeysBitset current_set{};
         current_set.set(key);
+        RMB_TRACE_STAMP(KeyQueued);
         up_keys_queue_.enqueue(current_set);
     }
     
@@ -0,0 +1,83 @@
+#include "linux_config_watcher.h"
+
+#include <errno.h>
+#include <limits.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+#include <cstdio>
+#include <cstring>
+
+ConfigWatcher::ConfigWatcher(const std::string& path, Callback on_change)
+    : on_change_(std::move(on_change)) {
+    const size_t separator = path.find_last_of('/');
+    const std::string directory = separator == std::string::npos ? "." : path.substr(0, separator);
+    file_name_ = separator == std::string::npos ? path : path.substr(separator + 1);
+
+    inotify_fd_ = inotify_init1(IN_CLOEXEC | IN_NONBLOCK);
+    if (inotify_fd_ < 0) {
+        fprintf(stderr, "Couldn't watch %s for changes: %s\n", path.c_str(), strerror(errno));
+        return;
+    }
+    /* written in place or renamed over by an editor */
+    if (inotify_add_watch(inotify_fd_, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO) < 0) {
+        fprintf(stderr, "Couldn't watch %s for changes: %s\n", path.c_str(), strerror(errno));
+        return;
+    }
+
+    wake_fd_ = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (wake_fd_ < 0)
+        return;
+
+    thread_ = std::jthread([this](std::stop_token stop_token) { Run(stop_token); });
+}
+
+ConfigWatcher::~ConfigWatcher() {
+    if (thread_.joinable()) {
+        thread_.request_stop();
+        thread_.join();
+    }
+    if (wake_fd_ >= 0)
+        close(wake_fd_);
+    if (inotify_fd_ >= 0)
+        close(inotify_fd_);
+}
+
+void ConfigWatcher::Run(std::stop_token stop_token) {
+    std::stop_callback wake_on_stop(stop_token, [this] {
+        uint64_t one = 1;
+        (void)!write(wake_fd_, &one, sizeof(one));
+    });
+
+    pollfd fds[2] = {{inotify_fd_, POLLIN, 0}, {wake_fd_, POLLIN, 0}};
+    while (!stop_token.stop_requested()) {
+        if (poll(fds, 2, -1) < 0) {
+            if (errno == EINTR)
+                continue;
+            fprintf(stderr, "Config watcher poll failed: %d\n", errno);
+            break;
+        }
+        if ((fds[0].revents & POLLIN) && ReadEvents() && !stop_token.stop_requested()) {
+            on_change_();
+        }
+    }
+}
+
+bool ConfigWatcher::ReadEvents() {
+    /* a save usually comes as a few events, all of them end up in one callback */
+    alignas(inotify_event) char buffer[sizeof(inotify_event) + NAME_MAX + 1];
+    bool changed = false;
+    ssize_t length;
+    while ((length = read(inotify_fd_, buffer, sizeof(buffer))) > 0) {
+        for (ssize_t offset = 0; offset < length;) {
+            const auto* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+            if (event->len > 0 && file_name_ == event->name) {
+                changed = true;
+            }
+            offset += sizeof(inotify_event) + event->len;
+        }
+    }
+    return changed;
+}
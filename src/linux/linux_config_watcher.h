@@ -0,0 +1,35 @@
+#pragma once
+
+#include <functional>
+#include <string>
+#include <thread>
+
+/* Calls `on_change` from its own thread whenever the file was written or replaced, sleeps in
+ * poll while nothing happens. The directory is watched so editors which write a new file and
+ * rename it over the old one are noticed as well. */
+class ConfigWatcher {
+public:
+    using Callback = std::function<void()>;
+
+    ConfigWatcher(const std::string& path, Callback on_change);
+
+    ConfigWatcher(const ConfigWatcher&) = delete;
+    ConfigWatcher& operator=(const ConfigWatcher&) = delete;
+
+    ~ConfigWatcher();
+
+    bool IsInitialized() const {
+        return thread_.joinable();
+    }
+
+private:
+    void Run(std::stop_token stop_token);
+    /* true if one of the read events was about the watched file */
+    bool ReadEvents();
+
+    std::string file_name_;
+    Callback on_change_;
+    int inotify_fd_ = -1;
+    int wake_fd_ = -1;
+    std::jthread thread_;
+};
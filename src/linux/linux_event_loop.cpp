@@ -0,0 +1,131 @@
+#include "linux_event_loop.h"
+
+#include <errno.h>
+#include <stdio.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+#include <unistd.h>
+
+EventLoop::EventLoop() {
+    epoll_fd_ = epoll_create1(EPOLL_CLOEXEC);
+    if (epoll_fd_ < 0) {
+        fprintf(stderr, "Couldn't create the epoll instance: %d\n", errno);
+        return;
+    }
+
+    wake_fd_ = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (wake_fd_ < 0) {
+        fprintf(stderr, "Couldn't create the event loop's eventfd: %d\n", errno);
+        return;
+    }
+
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.u64 = wake_source;
+    if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, wake_fd_, &event) < 0) {
+        close(wake_fd_);
+        wake_fd_ = -1;
+    }
+}
+
+EventLoop::~EventLoop() {
+    for (const auto& source : sources_) {
+        if (source.is_timer)
+            close(source.fd);
+    }
+    if (wake_fd_ >= 0)
+        close(wake_fd_);
+    if (epoll_fd_ >= 0)
+        close(epoll_fd_);
+}
+
+bool EventLoop::AddFd(int fd, Callback callback) {
+    if (!IsInitialized() || fd < 0)
+        return false;
+
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.u64 = sources_.size();
+    if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &event) < 0) {
+        fprintf(stderr, "Couldn't watch fd %d: %d\n", fd, errno);
+        return false;
+    }
+    sources_.push_back({fd, false, std::move(callback)});
+    return true;
+}
+
+int EventLoop::AddTimer(Callback callback) {
+    if (!IsInitialized())
+        return -1;
+
+    const int fd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK);
+    if (fd < 0) {
+        fprintf(stderr, "Couldn't create a timerfd: %d\n", errno);
+        return -1;
+    }
+
+    epoll_event event{};
+    event.events = EPOLLIN;
+    event.data.u64 = sources_.size();
+    if (epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &event) < 0) {
+        close(fd);
+        return -1;
+    }
+    sources_.push_back({fd, true, std::move(callback)});
+    return static_cast<int>(sources_.size() - 1);
+}
+
+void EventLoop::SetTimer(int timer, std::chrono::nanoseconds period) {
+    if (timer < 0 || static_cast<size_t>(timer) >= sources_.size() || !sources_[timer].is_timer)
+        return;
+
+    const auto seconds = std::chrono::duration_cast<std::chrono::seconds>(period);
+    itimerspec spec{};
+    spec.it_interval.tv_sec = seconds.count();
+    spec.it_interval.tv_nsec = (period - seconds).count();
+    /* zero disarms */
+    spec.it_value = spec.it_interval;
+    timerfd_settime(sources_[timer].fd, 0, &spec, nullptr);
+}
+
+void EventLoop::Wake() {
+    uint64_t one = 1;
+    (void)!write(wake_fd_, &one, sizeof(one));
+}
+
+void EventLoop::Run(std::stop_token stop_token, const Callback& after_round,
+                    const std::function<bool()>& has_pending) {
+    std::stop_callback wake_on_stop(stop_token, [this] { Wake(); });
+
+    epoll_event events[max_events];
+    while (!stop_token.stop_requested()) {
+        const int timeout = has_pending && has_pending() ? 0 : -1;
+        const int count = epoll_wait(epoll_fd_, events, max_events, timeout);
+        if (count < 0) {
+            if (errno == EINTR)
+                continue;
+            fprintf(stderr, "Event loop wait failed: %d\n", errno);
+            break;
+        }
+
+        for (int i = 0; i < count; i++) {
+            const uint64_t index = events[i].data.u64;
+            uint64_t expirations = 0;
+            if (index == wake_source) {
+                (void)!read(wake_fd_, &expirations, sizeof(expirations));
+                continue;
+            }
+
+            Source& source = sources_[index];
+            /* missed timer periods are not caught up, one call per wake up */
+            if (source.is_timer && read(source.fd, &expirations, sizeof(expirations)) < 0)
+                continue;
+            if (source.callback)
+                source.callback();
+        }
+
+        if (after_round)
+            after_round();
+    }
+}
@@ -0,0 +1,54 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <stop_token>
+#include <vector>
+
+/* Single threaded epoll reactor. Sleeps until a watched fd becomes readable or an armed timerfd
+ * expires, so nothing wakes up while there is no input and no timer is armed. */
+class EventLoop {
+public:
+    using Callback = std::function<void()>;
+
+    EventLoop();
+
+    EventLoop(const EventLoop&) = delete;
+    EventLoop& operator=(const EventLoop&) = delete;
+
+    ~EventLoop();
+
+    bool IsInitialized() const {
+        return epoll_fd_ >= 0 && wake_fd_ >= 0;
+    }
+
+    /* sources have to be added before `Run`, the callback may be empty */
+    bool AddFd(int fd, Callback callback);
+    /* returns the timer id or -1, the timer stays disarmed until `SetTimer` */
+    int AddTimer(Callback callback);
+
+    /* thread safe, a zero period disarms the timer */
+    void SetTimer(int timer, std::chrono::nanoseconds period);
+    /* thread safe, makes `Run` go through one more round */
+    void Wake();
+
+    /* `after_round` runs after the callbacks of every wake up. while `has_pending` returns true
+     * there is input which won't make any fd readable, the loop goes on without sleeping */
+    void Run(std::stop_token stop_token, const Callback& after_round,
+             const std::function<bool()>& has_pending = nullptr);
+
+private:
+    struct Source {
+        int fd;
+        bool is_timer;
+        Callback callback;
+    };
+
+    static constexpr uint64_t wake_source = UINT64_MAX;
+    static constexpr int max_events = 16;
+
+    int epoll_fd_ = -1;
+    int wake_fd_ = -1;
+    std::vector<Source> sources_;
+};
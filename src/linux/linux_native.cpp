@@ -1,15 +1,27 @@
 #include "linux_native.h"
+#include "linux_uinput.h"
+#include "linux_window_tracker.h"
 
 #include <functional>
 #include <thread>
+#include "Tracer.h"
 #include "Utils.h"
+#include "input_trace.h"
 
+#include <errno.h>
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <GLFW/glfw3.h>
 #include <X11/XKBlib.h>
 #include <X11/Xlib.h>
 #include <X11/Xlibint.h>
 #include <X11/Xutil.h>
+#include <X11/keysym.h>
 #include <X11/extensions/XInput2.h>
 #include <X11/extensions/XTest.h>
+#include <X11/extensions/Xfixes.h>
 #include <X11/extensions/record.h>
 
 typedef union {
@@ -81,6 +93,10 @@ public:
     Display* GetDisplay() const {
         return record_display_;
     }
+    /* readable whenever there are recorded events for `Update` */
+    int GetFd() const {
+        return initialized_ ? ConnectionNumber(data_display_) : -1;
+    }
     bool IsInitialized() const {
         return initialized_;
     }
@@ -92,6 +108,134 @@ private:
     XRecordContext context_;
 };
 
+/* Listens for XInput2 raw motion on its own connection and publishes the relative device deltas,
+ * blocks on the connection fd so nothing runs while the mouse is still. After `StopThread` the
+ * owner has to call `Update` when the fd is readable. */
+class XRawMotionHandler {
+public:
+    XRawMotionHandler() {
+        display_ = XOpenDisplay(nullptr);
+        if (!display_)
+            return;
+
+        int event, error;
+        if (!XQueryExtension(display_, "XInputExtension", &xi_opcode_, &event, &error)) {
+            fprintf(stderr, "XInput extension is not available.\n");
+            return;
+        }
+
+        int major = 2, minor = 2;
+        if (XIQueryVersion(display_, &major, &minor) != Success) {
+            fprintf(stderr, "XInput2 is not available.\n");
+            return;
+        }
+        fprintf(stdout, "XInput Version: %d, %d\n", major, minor);
+
+        unsigned char mask_bits[XIMaskLen(XI_RawMotion)]{};
+        XIEventMask mask{XIAllMasterDevices, sizeof(mask_bits), mask_bits};
+        XISetMask(mask_bits, XI_RawMotion);
+        XISelectEvents(display_, XDefaultRootWindow(display_), &mask, 1);
+        XFlush(display_);
+
+        wake_fd_ = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+        if (wake_fd_ < 0)
+            return;
+
+        initialized_ = true;
+        thread_ = std::jthread([this](std::stop_token stop_token) { Run(stop_token); });
+    }
+
+    ~XRawMotionHandler() {
+        StopThread();
+        initialized_ = false;
+        if (wake_fd_ >= 0)
+            close(wake_fd_);
+        if (display_)
+            XCloseDisplay(display_);
+        wake_fd_ = -1;
+        display_ = nullptr;
+    }
+
+    bool IsInitialized() const {
+        return initialized_;
+    }
+    bool IsThreaded() const {
+        return thread_.joinable();
+    }
+    int GetFd() const {
+        return ConnectionNumber(display_);
+    }
+
+    void StopThread() {
+        if (thread_.joinable()) {
+            thread_.request_stop();
+            thread_.join();
+        }
+    }
+
+    /* XPending also reads whatever arrived on the fd, drains all of it as one delta */
+    void Update() {
+        float dx = 0.f, dy = 0.f;
+        while (XPending(display_)) {
+            XEvent event;
+            XNextEvent(display_, &event);
+            ReadRawMotion(event, &dx, &dy);
+        }
+
+        if (dx != 0.f || dy != 0.f) {
+            EventBus::Instance().publish(MouseMotionEvent(dx, dy));
+        }
+    }
+
+private:
+    void Run(std::stop_token stop_token) {
+        std::stop_callback wake_on_stop(stop_token, [this] {
+            uint64_t one = 1;
+            (void)!write(wake_fd_, &one, sizeof(one));
+        });
+
+        pollfd fds[2] = {{ConnectionNumber(display_), POLLIN, 0}, {wake_fd_, POLLIN, 0}};
+        while (!stop_token.stop_requested()) {
+            Update();
+
+            if (poll(fds, 2, -1) < 0 && errno != EINTR) {
+                fprintf(stderr, "XInput2 raw motion poll failed: %d\n", errno);
+                break;
+            }
+        }
+    }
+
+    void ReadRawMotion(XEvent& event, float* dx, float* dy) {
+        XGenericEventCookie* cookie = &event.xcookie;
+        if (cookie->type != GenericEvent || cookie->extension != xi_opcode_ ||
+            !XGetEventData(display_, cookie)) {
+            return;
+        }
+
+        if (cookie->evtype == XI_RawMotion) {
+            const XIRawEvent* raw = static_cast<XIRawEvent*>(cookie->data);
+            const double* raw_value = raw->raw_values;
+            /* only the set valuators have values, first two are the x and y axis */
+            for (int axis = 0; axis < 2 && axis < raw->valuators.mask_len * 8; axis++) {
+                if (!XIMaskIsSet(raw->valuators.mask, axis))
+                    continue;
+                if (axis == 0)
+                    *dx += static_cast<float>(*raw_value);
+                else
+                    *dy += static_cast<float>(*raw_value);
+                raw_value++;
+            }
+        }
+        XFreeEventData(display_, cookie);
+    }
+
+    bool initialized_ = false;
+    int xi_opcode_ = 0;
+    int wake_fd_ = -1;
+    Display* display_ = nullptr;
+    std::jthread thread_;
+};
+
 std::shared_ptr<Native> Native::GetInstance() {
     static std::shared_ptr<Native> singleton_(LinuxNative::GetInstance());
     return singleton_;
@@ -106,6 +250,10 @@ LinuxNative* LinuxNative::GetInstance() {
 LinuxNative* LinuxNative::instance_ = nullptr;
 
 LinuxNative::LinuxNative() {
+    /* the key scheduler sends on its own thread through `display_`, Xlib has to lock the
+     * connections. GLFW does the same in `glfwInit`, which headless mode never calls */
+    if (!XInitThreads())
+        fprintf(stderr, "Couldn't initialize Xlib for threads.\n");
     xrecord_handler_ = new XRecordHandler(HookEvent);
     if (!xrecord_handler_->IsInitialized())
         return;
@@ -114,6 +262,30 @@ LinuxNative::LinuxNative() {
 
     if (!display_)
         return;
+
+    window_tracker_ = new XWindowTracker(display_);
+
+    raw_motion_handler_ = new XRawMotionHandler();
+    if (!raw_motion_handler_->IsInitialized()) {
+        delete raw_motion_handler_;
+        raw_motion_handler_ = nullptr;
+    }
+    int xkb_error, xkb_major = XkbMajorVersion, xkb_minor = XkbMinorVersion;
+    if (XkbQueryExtension(display_, &xkb_opcode_, &xkb_event_base_, &xkb_error, &xkb_major,
+                          &xkb_minor)) {
+        XkbSelectEventDetails(display_, XkbUseCoreKbd, XkbStateNotify, XkbGroupStateMask,
+                              XkbGroupStateMask);
+        XkbSelectEvents(display_, XkbUseCoreKbd, XkbMapNotifyMask, XkbMapNotifyMask);
+
+        XkbStateRec state;
+        XkbGetState(display_, XkbUseCoreKbd, &state);
+        current_group_ = state.group;
+    }
+    else {
+        xkb_event_base_ = -1;
+    }
+    RefreshModifierMap();
+
     /* getting scan code infos */
 
     int keycode_low, keycode_high;
@@ -160,46 +332,120 @@ LinuxNative::LinuxNative() {
 }
 
 LinuxNative::~LinuxNative() {
+    if (uinput_gamepad_) {
+        delete uinput_gamepad_;
+    }
+    if (raw_motion_handler_) {
+        delete raw_motion_handler_;
+    }
+    if (window_tracker_) {
+        delete window_tracker_;
+    }
     if (xrecord_handler_) {
         delete xrecord_handler_;
     }
     if (display_) {
+        ReleasePointer();
         CursorHide(false);
+        if (modifier_map_)
+            XFreeModifiermap(modifier_map_);
         XCloseDisplay(display_);
     }
     registered_keys_.clear();
     instance_ = nullptr;
 }
 
+size_t LinuxNative::UseEventLoop(int* fds, size_t max_fds) {
+    if (!display_ || max_fds < 3)
+        return 0;
+
+    size_t count = 0;
+    fds[count++] = ConnectionNumber(display_);
+    fds[count++] = xrecord_handler_->GetFd();
+    if (raw_motion_handler_) {
+        raw_motion_handler_->StopThread();
+        fds[count++] = raw_motion_handler_->GetFd();
+    }
+    return count;
+}
+
+bool LinuxNative::HasPendingEvents() {
+    if (!display_)
+        return false;
+    /* the other threads' requests may read events into the queue, like `XSync` of
+     * `RegisterHotKey`, or wait for a reply which hasn't been sent yet */
+    XFlush(display_);
+    return XEventsQueued(display_, QueuedAlready) > 0;
+}
+
 void LinuxNative::Update() {
     XEvent event;
-    if (XCheckWindowEvent(display_, XDefaultRootWindow(display_), KeyPressMask, &event)) {
-        switch (event.type) {
-        case KeyPress: {
-            const auto& key_data = event.xkey;
-            uint32_t hash = HashRegKey(key_data.keycode, key_data.state & ~(LockMask | Mod2Mask));
-            auto matched_reg_key_it = registered_keys_.find(hash);
-            if (matched_reg_key_it != registered_keys_.cend()) {
-                const auto& matched_reg_key = matched_reg_key_it->second;
-                EventBus::Instance().publish(
-                    HotkeyEvent(matched_reg_key.key, matched_reg_key.modifier));
-            }
-            else {
-                hash = HashRegKey(key_data.keycode, AnyModifier);
-                matched_reg_key_it = registered_keys_.find(hash);
-                if (matched_reg_key_it != registered_keys_.cend()) {
-                    const auto& matched_reg_key = matched_reg_key_it->second;
-                    EventBus::Instance().publish(
-                        HotkeyEvent(matched_reg_key.key, matched_reg_key.modifier));
-                }
-            }
-            break;
+    /* drains the whole queue, with an event loop neither the fd nor `HasPendingEvents` would let
+     * it sleep with anything left in there */
+    while (XPending(display_)) {
+        XNextEvent(display_, &event);
+        if (event.type == KeyPress) {
+            HandleHotKey(event.xkey);
+        }
+        /* keyboard layout/state changes, keeps the cached state used by `SendKeys` up to date */
+        else if (event.type == MappingNotify) {
+            XRefreshKeyboardMapping(&event.xmapping);
+            RefreshModifierMap();
         }
+        /* focus and window changes, these have to be drained even when nobody asks about them */
+        else if (XWindowTracker::IsTrackerEvent(display_, &event, nullptr)) {
+            focus_changed_ |= window_tracker_->HandleEvent(event);
         }
+        else if (xkb_event_base_ >= 0 && event.type == xkb_event_base_) {
+            HandleXkbEvent(*reinterpret_cast<XkbEvent*>(&event));
+        }
+    }
+    if (focus_changed_) {
+        focus_changed_ = false;
+        std::string window_class, window_title;
+        window_tracker_->GetActiveWindowNames(&window_class, &window_title);
+        EventBus::Instance().publish(FocusChangedEvent(window_class, window_title));
     }
+
     if (xrecord_handler_) {
         xrecord_handler_->Update();
     }
+    if (raw_motion_handler_ && !raw_motion_handler_->IsThreaded()) {
+        raw_motion_handler_->Update();
+    }
+}
+
+void LinuxNative::HandleHotKey(const XKeyEvent& key_data) {
+    uint32_t hash = HashRegKey(key_data.keycode, key_data.state & ~(LockMask | Mod2Mask));
+    auto matched_reg_key_it = registered_keys_.find(hash);
+    if (matched_reg_key_it == registered_keys_.cend()) {
+        hash = HashRegKey(key_data.keycode, AnyModifier);
+        matched_reg_key_it = registered_keys_.find(hash);
+    }
+    if (matched_reg_key_it != registered_keys_.cend()) {
+        const auto& matched_reg_key = matched_reg_key_it->second;
+        EventBus::Instance().publish(HotkeyEvent(matched_reg_key.key, matched_reg_key.modifier));
+    }
+}
+
+void LinuxNative::HandleXkbEvent(const XkbEvent& xkb_event) {
+    if (xkb_event.any.xkb_type == XkbStateNotify) {
+        const XkbStateNotifyEvent& state = xkb_event.state;
+        /* a layout switch by key has the keycode set, a lock request from `SendKeys` only moves
+         * to a key's group and back. skipping it keeps the next batch from taking the temporary
+         * group for the user's one */
+        const bool is_lock_request = state.keycode == 0 &&
+                                     static_cast<uint8_t>(state.req_major) == xkb_opcode_ &&
+                                     state.req_minor == X_kbLatchLockState;
+        if (is_lock_request && pending_group_locks_ > 0) {
+            pending_group_locks_--;
+            return;
+        }
+        current_group_ = state.group;
+    }
+    else if (xkb_event.any.xkb_type == XkbMapNotify) {
+        RefreshModifierMap();
+    }
 }
 
 void LinuxNative::RegisterHotKey(uint32_t key, uint32_t modifier) {
@@ -269,17 +515,11 @@ void LinuxNative::UnregisterHotKey(uint32_t key, uint32_t modifier) {
 }
 
 void LinuxNative::SendKeysDown(uint32_t* keys, size_t count) {
-    for (size_t i = 0; i < count; i++) {
-        SendKey(keys[i], true);
-    }
-    XFlush(display_);
+    SendKeys(keys, count, true);
 }
 
 void LinuxNative::SendKeysUp(uint32_t* keys, size_t count) {
-    for (size_t i = 0; i < count; i++) {
-        SendKey(keys[i], false);
-    }
-    XFlush(display_);
+    SendKeys(keys, count, false);
 }
 
 void LinuxNative::SetMousePos(int x, int y) {
@@ -302,6 +542,125 @@ void LinuxNative::GetMousePos(int* x_ret, int* y_ret) {
     }
 }
 
+bool LinuxNative::GetScreenSize(int* width, int* height) {
+    if (!display_)
+        return false;
+    const int screen = DefaultScreen(display_);
+    *width = DisplayWidth(display_, screen);
+    *height = DisplayHeight(display_, screen);
+    return true;
+}
+
+/* the reverse of GLFW's own keysym translation, US layout symbols for the printable keys */
+static KeySym GlfwKeyToKeySym(int key) {
+    if (key >= GLFW_KEY_A && key <= GLFW_KEY_Z)
+        return XK_a + (key - GLFW_KEY_A);
+    if (key >= GLFW_KEY_0 && key <= GLFW_KEY_9)
+        return XK_0 + (key - GLFW_KEY_0);
+    if (key >= GLFW_KEY_F1 && key <= GLFW_KEY_F25)
+        return XK_F1 + (key - GLFW_KEY_F1);
+    if (key >= GLFW_KEY_KP_0 && key <= GLFW_KEY_KP_9)
+        return XK_KP_0 + (key - GLFW_KEY_KP_0);
+
+    static constexpr struct {
+        int key;
+        KeySym symbol;
+    } key_symbols[] = {
+        {GLFW_KEY_SPACE, XK_space}, {GLFW_KEY_APOSTROPHE, XK_apostrophe},
+        {GLFW_KEY_COMMA, XK_comma}, {GLFW_KEY_MINUS, XK_minus}, {GLFW_KEY_PERIOD, XK_period},
+        {GLFW_KEY_SLASH, XK_slash}, {GLFW_KEY_SEMICOLON, XK_semicolon}, {GLFW_KEY_EQUAL, XK_equal},
+        {GLFW_KEY_LEFT_BRACKET, XK_bracketleft}, {GLFW_KEY_BACKSLASH, XK_backslash},
+        {GLFW_KEY_RIGHT_BRACKET, XK_bracketright}, {GLFW_KEY_GRAVE_ACCENT, XK_grave},
+        {GLFW_KEY_WORLD_1, XK_less}, {GLFW_KEY_ESCAPE, XK_Escape}, {GLFW_KEY_ENTER, XK_Return},
+        {GLFW_KEY_TAB, XK_Tab}, {GLFW_KEY_BACKSPACE, XK_BackSpace}, {GLFW_KEY_INSERT, XK_Insert},
+        {GLFW_KEY_DELETE, XK_Delete}, {GLFW_KEY_RIGHT, XK_Right}, {GLFW_KEY_LEFT, XK_Left},
+        {GLFW_KEY_DOWN, XK_Down}, {GLFW_KEY_UP, XK_Up}, {GLFW_KEY_PAGE_UP, XK_Page_Up},
+        {GLFW_KEY_PAGE_DOWN, XK_Page_Down}, {GLFW_KEY_HOME, XK_Home}, {GLFW_KEY_END, XK_End},
+        {GLFW_KEY_CAPS_LOCK, XK_Caps_Lock}, {GLFW_KEY_SCROLL_LOCK, XK_Scroll_Lock},
+        {GLFW_KEY_NUM_LOCK, XK_Num_Lock}, {GLFW_KEY_PRINT_SCREEN, XK_Print},
+        {GLFW_KEY_PAUSE, XK_Pause}, {GLFW_KEY_KP_DECIMAL, XK_KP_Decimal},
+        {GLFW_KEY_KP_DIVIDE, XK_KP_Divide}, {GLFW_KEY_KP_MULTIPLY, XK_KP_Multiply},
+        {GLFW_KEY_KP_SUBTRACT, XK_KP_Subtract}, {GLFW_KEY_KP_ADD, XK_KP_Add},
+        {GLFW_KEY_KP_ENTER, XK_KP_Enter}, {GLFW_KEY_KP_EQUAL, XK_KP_Equal},
+        {GLFW_KEY_LEFT_SHIFT, XK_Shift_L}, {GLFW_KEY_LEFT_CONTROL, XK_Control_L},
+        {GLFW_KEY_LEFT_ALT, XK_Alt_L}, {GLFW_KEY_LEFT_SUPER, XK_Super_L},
+        {GLFW_KEY_RIGHT_SHIFT, XK_Shift_R}, {GLFW_KEY_RIGHT_CONTROL, XK_Control_R},
+        {GLFW_KEY_RIGHT_ALT, XK_Alt_R}, {GLFW_KEY_RIGHT_SUPER, XK_Super_R}, {GLFW_KEY_MENU, XK_Menu}
+    };
+    for (const auto& key_symbol : key_symbols) {
+        if (key_symbol.key == key)
+            return key_symbol.symbol;
+    }
+    return NoSymbol;
+}
+
+int LinuxNative::GetKeyScancode(int key) {
+    const KeySym symbol = GlfwKeyToKeySym(key);
+    if (!display_ || symbol == NoSymbol)
+        return -1;
+    const KeyCode keycode = XKeysymToKeycode(display_, symbol);
+    return keycode ? keycode : -1;
+}
+
+bool LinuxNative::HasRawMouseMotion() {
+    return raw_motion_handler_ != nullptr;
+}
+
+bool LinuxNative::ConfinePointer(int x, int y) {
+    /* half the size of the box the cursor is kept in */
+    constexpr int confine_radius = 16;
+
+    int event_base, error_base, major = 0, minor = 0;
+    if (!XFixesQueryExtension(display_, &event_base, &error_base) ||
+        !XFixesQueryVersion(display_, &major, &minor) || major < 5) {
+        fprintf(stderr, "XFixes pointer barriers are not available.\n");
+        return false;
+    }
+
+    ReleasePointer();
+
+    int screen = 0;
+    GetDefaultScreenMousePos(nullptr, nullptr, &screen, nullptr);
+    Window root = RootWindow(display_, screen);
+
+    const int left = x - confine_radius, right = x + confine_radius;
+    const int top = y - confine_radius, bottom = y + confine_radius;
+    /* every side only lets the cursor move back inside */
+    pointer_barriers_.push_back(XFixesCreatePointerBarrier(display_, root, left, top, left, bottom,
+                                                           BarrierPositiveX, 0, nullptr));
+    pointer_barriers_.push_back(XFixesCreatePointerBarrier(display_, root, right, top, right,
+                                                           bottom, BarrierNegativeX, 0, nullptr));
+    pointer_barriers_.push_back(XFixesCreatePointerBarrier(display_, root, left, top, right, top,
+                                                           BarrierPositiveY, 0, nullptr));
+    pointer_barriers_.push_back(XFixesCreatePointerBarrier(display_, root, left, bottom, right,
+                                                           bottom, BarrierNegativeY, 0, nullptr));
+    XFlush(display_);
+    return true;
+}
+
+void LinuxNative::ReleasePointer() {
+    if (pointer_barriers_.empty())
+        return;
+    for (auto barrier : pointer_barriers_) {
+        XFixesDestroyPointerBarrier(display_, barrier);
+    }
+    pointer_barriers_.clear();
+    XFlush(display_);
+}
+
+VirtualGamepad* LinuxNative::GetVirtualGamepad() {
+    /* don't retry opening /dev/uinput on every reconfig once it failed */
+    if (!uinput_gamepad_ && !uinput_gamepad_failed_) {
+        uinput_gamepad_ = new UInputGamepad();
+        if (!uinput_gamepad_->IsInitialized()) {
+            delete uinput_gamepad_;
+            uinput_gamepad_ = nullptr;
+            uinput_gamepad_failed_ = true;
+        }
+    }
+    return uinput_gamepad_;
+}
+
 static int IgnoreBadWindow(Display* dpy, XErrorEvent* xerr) {
     if (xerr->error_code == BadWindow)
         return 0;
@@ -310,30 +669,10 @@ static int IgnoreBadWindow(Display* dpy, XErrorEvent* xerr) {
 }
 
 NativeWindow LinuxNative::GetFocusedWindow() {
-    if (!EWMHIsSupported("_NET_ACTIVE_WINDOW")) {
+    if (!window_tracker_->IsSupported(window_tracker_->GetAtoms().net_active_window)) {
         return 0;
     }
-    auto old_error_handler = XSetErrorHandler(IgnoreBadWindow);
-
-    Window active_window = 0;
-
-    long nitems;
-    auto request = XInternAtom(display_, "_NET_ACTIVE_WINDOW", false);
-    auto root = XDefaultRootWindow(display_);
-    auto data = GetWindowPropertyByAtom(root, request, &nitems, nullptr, nullptr);
-    if (nitems > 0) {
-        active_window = *(Window*)data;
-
-        XWindowAttributes attr;
-        XGetWindowAttributes(display_, active_window, &attr);
-
-        if (attr.map_state != IsViewable) {
-            active_window = 0;
-        }
-        free(data);
-    }
-    XSetErrorHandler(old_error_handler);
-    return active_window;
+    return window_tracker_->GetActiveWindow();
 }
 
 bool LinuxNative::SetFocusOnWindow(const NativeWindow native_window) {
@@ -342,48 +681,20 @@ bool LinuxNative::SetFocusOnWindow(const NativeWindow native_window) {
 }
 
 bool LinuxNative::IsMainWindowActive(const std::string& window_name) {
-    static auto atom_window_type_id = XInternAtom(display_, "_NET_WM_WINDOW_TYPE", true);
-    static auto atom_target_type = XInternAtom(display_, "_NET_WM_WINDOW_TYPE_NORMAL", true);
-    if (!EWMHIsSupported("_NET_ACTIVE_WINDOW")) {
+    /* answered from the cache, the tracker follows _NET_ACTIVE_WINDOW through PropertyNotify */
+    if (!window_tracker_->IsSupported(window_tracker_->GetAtoms().net_active_window)) {
         return false;
     }
-
-    bool is_active = false;
-
-    auto old_error_handler = XSetErrorHandler(IgnoreBadWindow);
-
-    long nitems;
-    auto request = XInternAtom(display_, "_NET_ACTIVE_WINDOW", false);
-    auto root = XDefaultRootWindow(display_);
-    auto data = GetWindowPropertyByAtom(root, request, &nitems, nullptr, nullptr);
-    if (nitems > 0) {
-        auto active_window = *(Window*)data;
-
-        XWindowAttributes attr;
-        XClassHint classhint;
-        XGetWindowAttributes(display_, active_window, &attr);
-
-        if (attr.map_state != IsViewable) {
-            is_active = false;
-        }
-        else if (XGetClassHint(display_, active_window, &classhint)) {
-            if (classhint.res_name && strstr(classhint.res_name, window_name.c_str())) {
-                Atom* atom_window_type =
-                    (Atom*)GetWindowPropertyByAtom(active_window, atom_window_type_id);
-                is_active = atom_window_type && atom_target_type == *atom_window_type;
-                free(atom_window_type);
-            }
-            XFree(classhint.res_name);
-            XFree(classhint.res_class);
-        }
-
-        free(data);
-    }
-    XSetErrorHandler(old_error_handler);
-    return is_active;
+    return window_tracker_->IsActiveWindow(window_name);
 }
 
 bool LinuxNative::SetFocusOnWindow(const std::string& window_name) {
+    /* the tracker indexes the _NET_CLIENT_LIST windows, only walk the whole tree without it */
+    if (window_tracker_->IsSupported(window_tracker_->GetAtoms().net_client_list)) {
+        const Window window = window_tracker_->FindWindow(window_name);
+        return window && ActivateWindow(window);
+    }
+
     struct EnumWind {
         LinuxNative* sender_;
         const char* target_proc_name;
@@ -394,10 +705,9 @@ bool LinuxNative::SetFocusOnWindow(const std::string& window_name) {
     EnumAllWindow(
         [](Window window, void* ptr) {
             EnumWind* ew = (EnumWind*)ptr;
-            static auto atom_window_type_id =
-                XInternAtom(ew->sender_->display_, "_NET_WM_WINDOW_TYPE", true);
-            static auto atom_target_type =
-                XInternAtom(ew->sender_->display_, "_NET_WM_WINDOW_TYPE_NORMAL", true);
+            const auto& atoms = ew->sender_->window_tracker_->GetAtoms();
+            const auto atom_window_type_id = atoms.net_wm_window_type;
+            const auto atom_target_type = atoms.net_wm_window_type_normal;
 
             XWindowAttributes attr;
             XClassHint classhint;
@@ -541,125 +851,91 @@ uint32_t LinuxNative::HashRegKey(int key, uint32_t modmask) {
     return key * 0x7FFFu + modmask;
 }
 
-uint32_t LinuxNative::KeyCodeToModifier(KeyCode keycode) {
-    XModifierKeymap* modmap = XGetModifierMapping(display_);
-    uint32_t res = 0;
-    for (int i = 0; i < 8; i++) {
-        for (int j = 0;
-             j < modmap->max_keypermod && modmap->modifiermap[(i * modmap->max_keypermod) + j];
-             j++) {
-            if (keycode == modmap->modifiermap[(i * modmap->max_keypermod) + j]) {
-                switch (i) {
-                case ShiftMapIndex:
-                    res = ShiftMask;
-                    goto RET;
-                case LockMapIndex:
-                    res = LockMask;
-                    goto RET;
-                case ControlMapIndex:
-                    res = ControlMask;
-                    goto RET;
-                case Mod1MapIndex:
-                    res = Mod1Mask;
-                    goto RET;
-                case Mod2MapIndex:
-                    res = Mod2Mask;
-                    goto RET;
-                case Mod3MapIndex:
-                    res = Mod3Mask;
-                    goto RET;
-                case Mod4MapIndex:
-                    res = Mod4Mask;
-                    goto RET;
-                case Mod5MapIndex:
-                    res = Mod5Mask;
-                    goto RET;
-                }
+void LinuxNative::RefreshModifierMap() {
+    std::scoped_lock<std::mutex> lock{keyboard_state_mutex_};
+    if (modifier_map_)
+        XFreeModifiermap(modifier_map_);
+    modifier_map_ = XGetModifierMapping(display_);
+
+    memset(keycode_modifiers_, 0, sizeof(keycode_modifiers_));
+    /* the first modifier a keycode is bound to wins */
+    for (int mod_index = ShiftMapIndex; mod_index <= Mod5MapIndex; mod_index++) {
+        for (int j = 0; j < modifier_map_->max_keypermod; j++) {
+            KeyCode keycode = modifier_map_->modifiermap[mod_index * modifier_map_->max_keypermod + j];
+            if (keycode && !keycode_modifiers_[keycode]) {
+                keycode_modifiers_[keycode] = static_cast<uint8_t>(1 << mod_index);
             }
         }
     }
-RET:
-    XFreeModifiermap(modmap);
-    return res;
 }
 
-void LinuxNative::SendKey(int key, bool is_down) {
-    XkbStateRec state;
-    if (scan_code_infos_.find(key) == scan_code_infos_.cend())
+uint32_t LinuxNative::KeyCodeToModifier(KeyCode keycode) {
+    return keycode_modifiers_[keycode];
+}
+
+void LinuxNative::SendKeys(const uint32_t* keys, size_t count, bool is_down) {
+    if (count == 0)
         return;
 
-    const auto& scan_code_info = scan_code_infos_[key];
+    std::scoped_lock<std::mutex> lock{keyboard_state_mutex_};
+    const int current_group = current_group_;
+    int locked_group = current_group;
 
-    XkbGetState(display_, XkbUseCoreKbd, &state);
-    int current_group = state.group;
-    XkbLockGroup(display_, XkbUseCoreKbd, scan_code_info.group);
+    for (size_t i = 0; i < count; i++) {
+        const uint32_t key = keys[i];
+        if (key >= 256)
+            continue;
+        auto scan_code_info = scan_code_infos_.find(key);
+        if (scan_code_info == scan_code_infos_.cend())
+            continue;
+
+        if (keycode_modifiers_[key]) {
+            SendModifier(keycode_modifiers_[key], is_down);
+            continue;
+        }
 
-    auto key_modifier = KeyCodeToModifier(key);
-    if (key_modifier) {
-        SendModifier(key_modifier, is_down);
-        XFlush(display_);
-        return;
+        /* only switch the layout group for the keys which actually live in another one */
+        if (static_cast<int>(scan_code_info->second.group) != locked_group) {
+            locked_group = static_cast<int>(scan_code_info->second.group);
+            pending_group_locks_++;
+            XkbLockGroup(display_, XkbUseCoreKbd, locked_group);
+        }
+        XTestFakeKeyEvent(display_, key, is_down, CurrentTime);
     }
 
-    XTestFakeKeyEvent(display_, key, is_down, CurrentTime);
-    XkbLockGroup(display_, XkbUseCoreKbd, current_group);
-    XSync(display_, false);
+    if (locked_group != current_group) {
+        pending_group_locks_++;
+        XkbLockGroup(display_, XkbUseCoreKbd, current_group);
+    }
     XFlush(display_);
 }
 
 void LinuxNative::SendModifier(int modmask, int is_press) {
-    XModifierKeymap* modifiers = XGetModifierMapping(display_);
     for (auto mod_index = ShiftMapIndex; mod_index <= Mod5MapIndex; mod_index++) {
         if (modmask & (1 << mod_index)) {
-            for (auto mod_key = 0; mod_key < modifiers->max_keypermod; mod_key++) {
+            for (auto mod_key = 0; mod_key < modifier_map_->max_keypermod; mod_key++) {
                 auto keycode =
-                    modifiers->modifiermap[mod_index * modifiers->max_keypermod + mod_key];
+                    modifier_map_->modifiermap[mod_index * modifier_map_->max_keypermod + mod_key];
                 if (keycode) {
                     XTestFakeKeyEvent(display_, keycode, is_press, CurrentTime);
-                    XSync(display_, false);
                     break;
                 }
             }
         }
     }
-    XFreeModifiermap(modifiers);
-}
-
-bool LinuxNative::EWMHIsSupported(const char* feature) {
-    long nitems = 0L;
-    Atom* results = nullptr;
-    long i = 0;
-
-    Window root;
-    Atom request;
-    Atom feature_atom;
-
-    request = XInternAtom(display_, "_NET_SUPPORTED", false);
-    feature_atom = XInternAtom(display_, feature, false);
-    root = XDefaultRootWindow(display_);
-
-    results = (Atom*)GetWindowPropertyByAtom(root, request, &nitems);
-    for (i = 0L; i < nitems; i++) {
-        if (results[i] == feature_atom) {
-            free(results);
-            return true;
-        }
-    }
-    free(results);
-
-    return false;
 }
 
 bool LinuxNative::ActivateWindow(Window window) {
-    if (EWMHIsSupported("_NET_ACTIVE_WINDOW") == false) {
+    const auto& atoms = window_tracker_->GetAtoms();
+    if (!window_tracker_->IsSupported(atoms.net_active_window)) {
         return false;
     }
 
-    if (EWMHIsSupported("_NET_WM_DESKTOP") == true &&
-        EWMHIsSupported("_NET_CURRENT_DESKTOP") == true) {
+    if (window_tracker_->IsSupported(atoms.net_wm_desktop) &&
+        window_tracker_->IsSupported(atoms.net_current_desktop)) {
         long nitems;
-        auto request = XInternAtom(display_, "_NET_WM_DESKTOP", false);
-        auto data = GetWindowPropertyByAtom(window, request, &nitems, nullptr, nullptr);
+        auto data =
+            GetWindowPropertyByAtom(window, atoms.net_wm_desktop, &nitems, nullptr, nullptr);
 
         if (nitems > 0) {
             auto root = RootWindow(display_, 0);
@@ -669,7 +945,7 @@ bool LinuxNative::ActivateWindow(Window window) {
             xev.type = ClientMessage;
             xev.xclient.display = display_;
             xev.xclient.window = root;
-            xev.xclient.message_type = XInternAtom(display_, "_NET_CURRENT_DESKTOP", false);
+            xev.xclient.message_type = atoms.net_current_desktop;
             xev.xclient.format = 32;
             xev.xclient.data.l[0] = desktop;
             xev.xclient.data.l[1] = CurrentTime;
@@ -685,7 +961,7 @@ bool LinuxNative::ActivateWindow(Window window) {
     xev.type = ClientMessage;
     xev.xclient.display = display_;
     xev.xclient.window = window;
-    xev.xclient.message_type = XInternAtom(display_, "_NET_ACTIVE_WINDOW", false);
+    xev.xclient.message_type = atoms.net_active_window;
     xev.xclient.format = 32;
     xev.xclient.data.l[0] = 2L;
     xev.xclient.data.l[1] = CurrentTime;
@@ -745,6 +1021,7 @@ void LinuxNative::HookEvent(XPointer closeure, XRecordInterceptData* recorded_da
              recorded_data->category == XRecordFromClient) {
         XRecordDatum* data = (XRecordDatum*)recorded_data->data;
         if (data->type == ButtonPress || data->type == ButtonRelease) {
+            RMB_TRACE_SCOPE("XRecordButton");
             auto is_pressed = data->type == ButtonPress;
             auto button = data->event.u.u.detail;
             switch (button) {
@@ -757,11 +1034,33 @@ void LinuxNative::HookEvent(XPointer closeure, XRecordInterceptData* recorded_da
             case Button3:
                 button = MOUSE_RBUTTON;
                 break;
+            /* the wheel is a press and a release for every tick */
+            case Button4:
+                button = MOUSE_WHEEL_UP;
+                break;
+            case Button5:
+                button = MOUSE_WHEEL_DOWN;
+                break;
+            case 6:
+                button = MOUSE_WHEEL_LEFT;
+                break;
+            case 7:
+                button = MOUSE_WHEEL_RIGHT;
+                break;
+            case 8:
+                button = MOUSE_XBUTTON1;
+                break;
+            case 9:
+                button = MOUSE_XBUTTON2;
+                break;
             default:
                 goto END;
             }
+            if (IsMouseWheel(button) && !is_pressed)
+                goto END;
             int x = data->event.u.keyButtonPointer.rootX;
             int y = data->event.u.keyButtonPointer.rootY;
+            InputTraceWriter::AddMouseButton(button, is_pressed);
             EventBus::Instance().publish(MouseButtonEvent(button, is_pressed, x, y));
         }
     }
@@ -3,13 +3,20 @@
 #include "../native.h"
 
 #include <X11/X.h>
+#include <X11/XKBlib.h>
 #include <X11/Xlib.h>
+#include <X11/extensions/Xfixes.h>
 #include <X11/extensions/record.h>
 
+#include <atomic>
+#include <mutex>
 #include <unordered_map>
 #include <vector>
 
 class XRecordHandler;
+class XRawMotionHandler;
+class XWindowTracker;
+class UInputGamepad;
 
 class LinuxNative : public Native {
 public:
@@ -28,11 +35,19 @@ public:
     void SendKeysUp(uint32_t* keys, size_t count) override;
     void SetMousePos(int x, int y) override;
     void GetMousePos(int* x_ret, int* y_ret) override;
+    bool GetScreenSize(int* width, int* height) override;
+    int GetKeyScancode(int key) override;
     NativeWindow GetFocusedWindow() override;
     bool SetFocusOnWindow(const NativeWindow) override;
     bool IsMainWindowActive(const std::string& window_name) override;
     bool SetFocusOnWindow(const std::string& window_name) override;
     void CursorHide(bool hide) override;
+    bool HasRawMouseMotion() override;
+    bool ConfinePointer(int x, int y) override;
+    void ReleasePointer() override;
+    VirtualGamepad* GetVirtualGamepad() override;
+    size_t UseEventLoop(int* fds, size_t max_fds) override;
+    bool HasPendingEvents() override;
     void Update() override;
 
 private:
@@ -56,19 +71,40 @@ private:
                                   Window* window_ret = nullptr);
     unsigned char* GetWindowPropertyByAtom(Window window, Atom atom, long* nitems = nullptr,
                                            Atom* type = nullptr, int* size = nullptr);
+    /* publishes the `HotkeyEvent` of a registered key */
+    void HandleHotKey(const XKeyEvent& key_data);
+    void HandleXkbEvent(const XkbEvent& xkb_event);
+    void RefreshModifierMap();
     uint32_t KeyCodeToModifier(KeyCode keycode);
     uint32_t HashRegKey(int key, uint32_t modmask);
     void EnumAllWindow(EnumWindowProc enumWindowProc, void* userDefinedPtr);
     static void HookEvent(XPointer closeure, XRecordInterceptData* recorded_data);
 
-    bool EWMHIsSupported(const char* feature);
     bool ActivateWindow(Window window);
-    void SendKey(int key, bool is_down);
+    void SendKeys(const uint32_t* keys, size_t count, bool is_down);
     void SendModifier(int modmask, int is_press);
 
     std::unordered_map<uint32_t, ScanCodeInfo> scan_code_infos_;
     std::unordered_map<uint32_t, RegKey> registered_keys_;
+    std::vector<PointerBarrier> pointer_barriers_;
+
+    /* cached keyboard state, refreshed from the MappingNotify/XkbStateNotify events in `Update` */
+    std::mutex keyboard_state_mutex_;
+    XModifierKeymap* modifier_map_ = nullptr;
+    uint8_t keycode_modifiers_[256]{};
+    /* the user's group, the ones `SendKeys` locks for a moment are left out */
+    std::atomic_int current_group_ = 0;
+    /* `XkbLockGroup` calls of `SendKeys` whose XkbStateNotify hasn't been seen yet */
+    std::atomic_int pending_group_locks_ = 0;
+    int xkb_opcode_ = 0;
+    int xkb_event_base_ = -1;
 
     Display* display_ = nullptr;
     XRecordHandler* xrecord_handler_ = nullptr;
+    XRawMotionHandler* raw_motion_handler_ = nullptr;
+    XWindowTracker* window_tracker_ = nullptr;
+    /* `FocusChangedEvent` is published on the next `Update`, the first one reports the start */
+    bool focus_changed_ = true;
+    UInputGamepad* uinput_gamepad_ = nullptr;
+    bool uinput_gamepad_failed_ = false;
 };
@@ -0,0 +1,134 @@
+#include "linux_uinput.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <iterator>
+#include <linux/uinput.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+/* indexed by `GamepadButton`, follows the evdev gamepad layout SDL and the emulators expect */
+static constexpr uint16_t button_codes[static_cast<size_t>(GamepadButton::Count)] = {
+    BTN_EAST,   /* A */
+    BTN_SOUTH,  /* B */
+    BTN_NORTH,  /* X */
+    BTN_WEST,   /* Y */
+    BTN_TL,     /* L */
+    BTN_TR,     /* R */
+    BTN_TL2,    /* ZL */
+    BTN_TR2,    /* ZR */
+    BTN_SELECT, /* Minus */
+    BTN_START,  /* Plus */
+    BTN_THUMBL, /* LStick */
+    BTN_THUMBR, /* RStick */
+};
+
+/* x and y of each `GamepadStick`, then the D-pad */
+static constexpr uint16_t axis_codes[][2] = {
+    {ABS_X, ABS_Y},
+    {ABS_RX, ABS_RY},
+    {ABS_HAT0X, ABS_HAT0Y},
+};
+
+UInputGamepad::UInputGamepad() {
+    fd_ = open("/dev/uinput", O_WRONLY | O_NONBLOCK | O_CLOEXEC);
+    if (fd_ < 0) {
+        fprintf(stderr, "Couldn't open /dev/uinput: %s\n", strerror(errno));
+        return;
+    }
+
+    bool ok = ioctl(fd_, UI_SET_EVBIT, EV_KEY) >= 0 && ioctl(fd_, UI_SET_EVBIT, EV_ABS) >= 0;
+    for (auto code : button_codes) {
+        ok = ok && ioctl(fd_, UI_SET_KEYBIT, code) >= 0;
+    }
+
+    /* both sticks are always there, without them most libraries won't treat this as a gamepad */
+    for (size_t i = 0; i < std::size(axis_codes); i++) {
+        const int32_t max = i < static_cast<size_t>(GamepadStick::Count) ? HID_JOYSTICK_MAX : 1;
+        for (auto axis : axis_codes[i]) {
+            uinput_abs_setup abs_setup{};
+            abs_setup.code = axis;
+            abs_setup.absinfo.minimum = -max;
+            abs_setup.absinfo.maximum = max;
+            ok = ok && ioctl(fd_, UI_SET_ABSBIT, axis) >= 0 &&
+                 ioctl(fd_, UI_ABS_SETUP, &abs_setup) >= 0;
+        }
+    }
+
+    uinput_setup setup{};
+    setup.id.bustype = BUS_VIRTUAL;
+    setup.id.vendor = 0x524d; /* "RM" */
+    setup.id.product = 0x0042;
+    setup.id.version = 1;
+    snprintf(setup.name, UINPUT_MAX_NAME_SIZE, "RMB Virtual Gamepad");
+
+    ok = ok && ioctl(fd_, UI_DEV_SETUP, &setup) >= 0 && ioctl(fd_, UI_DEV_CREATE) >= 0;
+    if (!ok) {
+        fprintf(stderr, "Couldn't create the uinput gamepad: %s\n", strerror(errno));
+        close(fd_);
+        fd_ = -1;
+        return;
+    }
+    fprintf(stdout, "Created uinput gamepad.\n");
+}
+
+UInputGamepad::~UInputGamepad() {
+    if (fd_ < 0)
+        return;
+    ioctl(fd_, UI_DEV_DESTROY);
+    close(fd_);
+    fd_ = -1;
+}
+
+void UInputGamepad::SetStick(GamepadStick stick, int32_t x, int32_t y) {
+    if (stick >= GamepadStick::Count)
+        return;
+    SetAxes(static_cast<size_t>(stick), x, y);
+}
+
+void UInputGamepad::SetDPad(int32_t x, int32_t y) {
+    SetAxes(static_cast<size_t>(GamepadStick::Count), x, y);
+}
+
+void UInputGamepad::SetAxes(size_t index, int32_t x, int32_t y) {
+    if (x != axes_x_[index]) {
+        Push(EV_ABS, axis_codes[index][0], x);
+        axes_x_[index] = x;
+    }
+    if (y != axes_y_[index]) {
+        Push(EV_ABS, axis_codes[index][1], y);
+        axes_y_[index] = y;
+    }
+}
+
+void UInputGamepad::SetButton(GamepadButton button, bool pressed) {
+    if (button >= GamepadButton::Count)
+        return;
+    Push(EV_KEY, button_codes[static_cast<size_t>(button)], pressed ? 1 : 0);
+}
+
+void UInputGamepad::Flush() {
+    if (pending_count_ == 0 || fd_ < 0)
+        return;
+
+    Push(EV_SYN, SYN_REPORT, 0);
+    const ssize_t size = static_cast<ssize_t>(pending_count_ * sizeof(input_event));
+    if (write(fd_, pending_, size) != size) {
+        fprintf(stderr, "uinput write failed: %s\n", strerror(errno));
+    }
+    pending_count_ = 0;
+}
+
+void UInputGamepad::Push(uint16_t type, uint16_t code, int32_t value) {
+    /* keep the room for the SYN_REPORT, a full buffer means the caller forgot to flush */
+    if (type != EV_SYN && pending_count_ + 1 >= max_pending_events) {
+        Flush();
+    }
+    input_event& event = pending_[pending_count_++];
+    event = {};
+    event.type = type;
+    event.code = code;
+    event.value = value;
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "../virtual_gamepad.h"
+
+#include <linux/input.h>
+
+#include <cstddef>
+
+class UInputGamepad : public VirtualGamepad {
+public:
+    UInputGamepad();
+
+    UInputGamepad(const UInputGamepad&) = delete;
+    UInputGamepad& operator=(const UInputGamepad&) = delete;
+
+    ~UInputGamepad() override;
+
+    bool IsInitialized() const {
+        return fd_ >= 0;
+    }
+
+    void SetStick(GamepadStick stick, int32_t x, int32_t y) override;
+    void SetDPad(int32_t x, int32_t y) override;
+    void SetButton(GamepadButton button, bool pressed) override;
+    void Flush() override;
+
+private:
+    void SetAxes(size_t index, int32_t x, int32_t y);
+    void Push(uint16_t type, uint16_t code, int32_t value);
+
+    /* the sticks, then the D-pad */
+    static constexpr size_t axes_count = static_cast<size_t>(GamepadStick::Count) + 1;
+    /* every button and every axis changing in the same frame plus the SYN_REPORT */
+    static constexpr size_t max_pending_events =
+        static_cast<size_t>(GamepadButton::Count) + axes_count * 2 + 1;
+
+    int fd_ = -1;
+    int32_t axes_x_[axes_count]{};
+    int32_t axes_y_[axes_count]{};
+    input_event pending_[max_pending_events]{};
+    size_t pending_count_ = 0;
+};
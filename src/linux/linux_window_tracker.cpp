@@ -0,0 +1,285 @@
+#include "linux_window_tracker.h"
+
+#include <X11/Xatom.h>
+#include <X11/Xutil.h>
+
+#include <algorithm>
+#include <iterator>
+
+static int IgnoreBadWindow(Display* display, XErrorEvent* error) {
+    (void)display;
+    if (error->error_code == BadWindow)
+        return 0;
+    return error->error_code;
+}
+
+XWindowTracker::XWindowTracker(Display* display) : display_(display) {
+    root_ = XDefaultRootWindow(display_);
+
+    /* interned once, all in a single round trip */
+    const char* names[] = {"_NET_SUPPORTED",      "_NET_ACTIVE_WINDOW",
+                           "_NET_CLIENT_LIST",    "_NET_WM_DESKTOP",
+                           "_NET_CURRENT_DESKTOP", "_NET_WM_WINDOW_TYPE",
+                           "_NET_WM_WINDOW_TYPE_NORMAL", "_NET_WM_NAME",
+                           "UTF8_STRING"};
+    Atom atoms[std::size(names)]{};
+    XInternAtoms(display_, const_cast<char**>(names), std::size(names), false, atoms);
+    atoms_ = {atoms[0], atoms[1], atoms[2],    atoms[3],  atoms[4], atoms[5],
+              atoms[6], atoms[7], atoms[8], XA_WM_CLASS, XA_WM_NAME};
+
+    /* keeps whatever the root mask already was, the hot keys come through grabs anyway */
+    XWindowAttributes attr;
+    XGetWindowAttributes(display_, root_, &attr);
+    XSelectInput(display_, root_, attr.your_event_mask | PropertyChangeMask);
+
+    std::scoped_lock<std::mutex> lock(mutex_);
+    RefreshSupported();
+    RefreshActiveWindow();
+    RefreshClientList();
+}
+
+Bool XWindowTracker::IsTrackerEvent(Display* display, XEvent* event, XPointer arg) {
+    (void)display;
+    (void)arg;
+    switch (event->type) {
+    case PropertyNotify:
+    case MapNotify:
+    case UnmapNotify:
+    case DestroyNotify:
+    /* nothing to do for these, StructureNotifyMask just comes with them */
+    case ConfigureNotify:
+    case ReparentNotify:
+    case GravityNotify:
+    case CirculateNotify:
+        return true;
+    }
+    return false;
+}
+
+bool XWindowTracker::HandleEvent(const XEvent& event) {
+    std::scoped_lock<std::mutex> lock(mutex_);
+    const WindowInfo last_active = active_;
+    switch (event.type) {
+    case PropertyNotify: {
+        const XPropertyEvent& property = event.xproperty;
+        if (property.window == root_) {
+            if (property.atom == atoms_.net_active_window)
+                RefreshActiveWindow();
+            else if (property.atom == atoms_.net_client_list)
+                RefreshClientList();
+            else if (property.atom == atoms_.net_supported)
+                RefreshSupported();
+        }
+        else if (property.atom == atoms_.wm_class || property.atom == atoms_.net_wm_window_type) {
+            if (property.window == active_.window)
+                RefreshWindowInfo(active_);
+            /* re-added so it is indexed under the new name */
+            if (clients_.contains(property.window)) {
+                RemoveClient(property.window);
+                AddClient(property.window);
+            }
+        }
+        else if (property.atom == atoms_.net_wm_name || property.atom == atoms_.wm_name) {
+            if (property.window == active_.window)
+                RefreshTitle(active_);
+        }
+        break;
+    }
+    case MapNotify:
+    case UnmapNotify: {
+        const Window window = event.type == MapNotify ? event.xmap.window : event.xunmap.window;
+        const bool viewable = event.type == MapNotify;
+        if (window == active_.window)
+            active_.viewable = viewable;
+        if (auto client = clients_.find(window); client != clients_.end())
+            client->second.viewable = viewable;
+        break;
+    }
+    case DestroyNotify:
+        if (event.xdestroywindow.window == active_.window)
+            active_ = {};
+        RemoveClient(event.xdestroywindow.window);
+        break;
+    }
+    return active_.window != last_active.window || active_.res_name != last_active.res_name ||
+           active_.title != last_active.title;
+}
+
+bool XWindowTracker::IsSupported(Atom feature) {
+    std::scoped_lock<std::mutex> lock(mutex_);
+    return std::ranges::find(supported_, feature) != supported_.end();
+}
+
+Window XWindowTracker::GetActiveWindow() {
+    std::scoped_lock<std::mutex> lock(mutex_);
+    return active_.viewable ? active_.window : 0;
+}
+
+bool XWindowTracker::IsActiveWindow(const std::string& window_name) {
+    std::scoped_lock<std::mutex> lock(mutex_);
+    return active_.window && IsTarget(active_, atoms_.net_wm_window_type_normal) &&
+           active_.res_name.find(window_name) != std::string::npos;
+}
+
+void XWindowTracker::GetActiveWindowNames(std::string* res_name, std::string* title) {
+    std::scoped_lock<std::mutex> lock(mutex_);
+    *res_name = active_.res_name;
+    *title = active_.title;
+}
+
+Window XWindowTracker::FindWindow(const std::string& window_name) {
+    std::scoped_lock<std::mutex> lock(mutex_);
+    auto [first, last] = clients_by_name_.equal_range(window_name);
+    for (auto it = first; it != last; ++it) {
+        if (IsTarget(clients_.at(it->second), atoms_.net_wm_window_type_normal))
+            return it->second;
+    }
+
+    /* the target name may only be a part of the WM_CLASS name, still no round trip */
+    for (const auto& [window, info] : clients_) {
+        if (IsTarget(info, atoms_.net_wm_window_type_normal) &&
+            info.res_name.find(window_name) != std::string::npos) {
+            return window;
+        }
+    }
+    return 0;
+}
+
+void XWindowTracker::RefreshSupported() {
+    unsigned long nitems = 0;
+    Atom* atoms = reinterpret_cast<Atom*>(GetProperty(root_, atoms_.net_supported, &nitems));
+    supported_.assign(atoms, atoms + (atoms ? nitems : 0));
+    if (atoms)
+        XFree(atoms);
+}
+
+void XWindowTracker::RefreshActiveWindow() {
+    Window window = 0;
+    unsigned long nitems = 0;
+    Window* data =
+        reinterpret_cast<Window*>(GetProperty(root_, atoms_.net_active_window, &nitems));
+    if (data && nitems > 0)
+        window = *data;
+    if (data)
+        XFree(data);
+
+    if (window == active_.window)
+        return;
+
+    active_ = {window, false, {}, None, {}};
+    if (window == 0)
+        return;
+
+    XSelectInput(display_, window, PropertyChangeMask | StructureNotifyMask);
+    RefreshWindowInfo(active_);
+    RefreshTitle(active_);
+}
+
+/* only the windows which were added or removed since the last time cost round trips */
+void XWindowTracker::RefreshClientList() {
+    unsigned long nitems = 0;
+    Window* windows =
+        reinterpret_cast<Window*>(GetProperty(root_, atoms_.net_client_list, &nitems));
+    if (!windows)
+        nitems = 0;
+
+    std::vector<Window> removed;
+    for (const auto& [window, info] : clients_) {
+        if (std::find(windows, windows + nitems, window) == windows + nitems)
+            removed.push_back(window);
+    }
+    for (const Window window : removed) {
+        RemoveClient(window);
+    }
+    for (unsigned long i = 0; i < nitems; i++) {
+        if (!clients_.contains(windows[i])) {
+            XSelectInput(display_, windows[i], PropertyChangeMask | StructureNotifyMask);
+            AddClient(windows[i]);
+        }
+    }
+
+    if (windows)
+        XFree(windows);
+}
+
+void XWindowTracker::AddClient(Window window) {
+    WindowInfo info{window, false, {}, None, {}};
+    RefreshWindowInfo(info);
+    clients_by_name_.emplace(info.res_name, window);
+    clients_.emplace(window, std::move(info));
+}
+
+void XWindowTracker::RemoveClient(Window window) {
+    auto client = clients_.find(window);
+    if (client == clients_.end())
+        return;
+
+    auto [first, last] = clients_by_name_.equal_range(client->second.res_name);
+    for (auto it = first; it != last; ++it) {
+        if (it->second == window) {
+            clients_by_name_.erase(it);
+            break;
+        }
+    }
+    clients_.erase(client);
+}
+
+bool XWindowTracker::IsTarget(const WindowInfo& info, Atom normal_type) {
+    return info.viewable && info.type == normal_type;
+}
+
+void XWindowTracker::RefreshWindowInfo(WindowInfo& info) {
+    /* the window may already be gone again */
+    auto old_error_handler = XSetErrorHandler(IgnoreBadWindow);
+
+    XWindowAttributes attr;
+    info.viewable =
+        XGetWindowAttributes(display_, info.window, &attr) && attr.map_state == IsViewable;
+
+    XClassHint classhint;
+    info.res_name.clear();
+    if (XGetClassHint(display_, info.window, &classhint)) {
+        if (classhint.res_name)
+            info.res_name = classhint.res_name;
+        XFree(classhint.res_name);
+        XFree(classhint.res_class);
+    }
+
+    unsigned long nitems = 0;
+    Atom* type =
+        reinterpret_cast<Atom*>(GetProperty(info.window, atoms_.net_wm_window_type, &nitems));
+    info.type = type && nitems > 0 ? *type : None;
+    if (type)
+        XFree(type);
+
+    XSetErrorHandler(old_error_handler);
+}
+
+/* `_NET_WM_NAME` is UTF-8, the old WM_NAME is only used when a window doesn't set it */
+void XWindowTracker::RefreshTitle(WindowInfo& info) {
+    auto old_error_handler = XSetErrorHandler(IgnoreBadWindow);
+
+    unsigned long nitems = 0;
+    char* name = reinterpret_cast<char*>(GetProperty(info.window, atoms_.net_wm_name, &nitems));
+    if (!name)
+        name = reinterpret_cast<char*>(GetProperty(info.window, atoms_.wm_name, &nitems));
+    info.title.assign(name ? name : "", name ? nitems : 0);
+    if (name)
+        XFree(name);
+
+    XSetErrorHandler(old_error_handler);
+}
+
+unsigned char* XWindowTracker::GetProperty(Window window, Atom atom, unsigned long* nitems) {
+    Atom actual_type;
+    int actual_format;
+    unsigned long bytes_after;
+    unsigned char* prop = nullptr;
+
+    if (XGetWindowProperty(display_, window, atom, 0, (~0L), false, AnyPropertyType, &actual_type,
+                           &actual_format, nitems, &bytes_after, &prop) != Success) {
+        *nitems = 0;
+        return nullptr;
+    }
+    return prop;
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <X11/Xlib.h>
+
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/* Keeps the EWMH state RMB asks about in memory, refreshed from the PropertyNotify and structure
+ * events of the root, the active window and every window in `_NET_CLIENT_LIST` instead of querying
+ * the server on every call. The events arrive on the owner's display, it has to pass them to
+ * `HandleEvent`. */
+class XWindowTracker {
+public:
+    struct Atoms {
+        Atom net_supported;
+        Atom net_active_window;
+        Atom net_client_list;
+        Atom net_wm_desktop;
+        Atom net_current_desktop;
+        Atom net_wm_window_type;
+        Atom net_wm_window_type_normal;
+        Atom net_wm_name;
+        Atom utf8_string;
+        Atom wm_class;
+        Atom wm_name;
+    };
+
+    explicit XWindowTracker(Display* display);
+
+    XWindowTracker(const XWindowTracker&) = delete;
+    XWindowTracker& operator=(const XWindowTracker&) = delete;
+
+    ~XWindowTracker() = default;
+
+    /* predicate for `XCheckIfEvent`, matches every event `HandleEvent` consumes */
+    static Bool IsTrackerEvent(Display* display, XEvent* event, XPointer arg);
+    /* true if the active window, its WM_CLASS name or its title changed */
+    bool HandleEvent(const XEvent& event);
+
+    const Atoms& GetAtoms() const {
+        return atoms_;
+    }
+    bool IsSupported(Atom feature);
+    /* 0 if there is none or it isn't viewable */
+    Window GetActiveWindow();
+    /* the active window is a viewable normal window whose WM_CLASS name contains `window_name` */
+    bool IsActiveWindow(const std::string& window_name);
+    /* WM_CLASS name and title of the active window, empty without one */
+    void GetActiveWindowNames(std::string* res_name, std::string* title);
+    /* a viewable normal client window whose WM_CLASS name is, or else contains, `window_name`,
+     * 0 if there is none */
+    Window FindWindow(const std::string& window_name);
+
+private:
+    struct WindowInfo {
+        Window window;
+        bool viewable;
+        std::string res_name;
+        Atom type;
+        /* only kept for the active window */
+        std::string title;
+    };
+
+    void RefreshSupported();
+    void RefreshActiveWindow();
+    void RefreshClientList();
+    void RefreshWindowInfo(WindowInfo& info);
+    void RefreshTitle(WindowInfo& info);
+    void AddClient(Window window);
+    void RemoveClient(Window window);
+    static bool IsTarget(const WindowInfo& info, Atom normal_type);
+    unsigned char* GetProperty(Window window, Atom atom, unsigned long* nitems);
+
+    Display* display_;
+    Window root_;
+    Atoms atoms_{};
+
+    std::mutex mutex_;
+    std::vector<Atom> supported_;
+    WindowInfo active_{};
+    std::unordered_map<Window, WindowInfo> clients_;
+    /* WM_CLASS name to the client windows with it */
+    std::unordered_multimap<std::string, Window> clients_by_name_;
+};
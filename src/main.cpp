@@ -1,14 +1,37 @@
+#include <cstring>
 #include <iostream>
 #include "Application.h"
 #include "Config.h"
+#include "input_trace.h"
+
+int main(int argc, char** argv) {
+    bool headless = false;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--headless") == 0) {
+            /* no window, the toggle hot key and the rest come from RMB.ini */
+            headless = true;
+        }
+        else if (strcmp(argv[i], "--record") == 0 && i + 1 < argc) {
+            /* raw pointer deltas, mouse buttons and the sent keys, see `RMB-sim --replay` */
+            if (!InputTraceWriter::Start(argv[++i]))
+                return 1;
+        }
+        else {
+            std::cerr << "Usage: " << argv[0] << " [--headless] [--record trace_file]" << std::endl;
+            return 1;
+        }
+    }
 
-int main(int, char**) {
     Application app{};
-    if (!app.Initialize(Config::Current()->NAME, Config::Current()->WIDTH,
-                        Config::Current()->HEIGHT)) {
+    const bool initialized =
+        headless ? app.InitializeHeadless()
+                 : app.Initialize(Config::Current()->NAME, Config::Current()->WIDTH,
+                                  Config::Current()->HEIGHT);
+    if (!initialized) {
         std::cerr << "Couldn't initialize the app" << std::endl;
         std::abort();
     }
     app.Run();
+    InputTraceWriter::Stop();
     return 0;
 }
\ No newline at end of file
@@ -1,56 +1,81 @@
+#include <algorithm>
 #include <cmath>
 #include <thread>
 #include "mouse.h"
 
-#include "Application.h"
 #include "Config.h"
+#include "Tracer.h"
 #include "Utils.h"
 #include "npad_controller.h"
+#include "thread_priority.h"
 
 #if _DEBUG
-#include "native.h"
+#include "key_scheduler.h"
 #endif
 
-Mouse::Mouse() {
-    update_thread = std::jthread([this](std::stop_token stop_token) { UpdateThread(stop_token); });
+Mouse::Mouse(NpadController* controller, bool threaded) : controller_(controller) {
+    if (threaded) {
+        update_thread =
+            std::jthread([this](std::stop_token stop_token) { UpdateThread(stop_token); });
+    }
 }
 
-void Mouse::MouseMoved(int x, int y, int center_x, int center_y) {
-    auto mouse_change = vf2d{static_cast<float>(x), static_cast<float>(y)} -
-                        vf2d{static_cast<float>(center_x), static_cast<float>(center_y)};
+void Mouse::SetPanning(bool value) {
+    std::scoped_lock<std::mutex> lock(mutex_);
+    /* nothing decays the last movement while an event loop doesn't tick us */
+    if (value && !panning_.load(std::memory_order_acquire)) {
+        StopPanning();
+    }
+    panning_.store(value, std::memory_order_release);
+}
 
-    const auto move_distance = mouse_change.mag();
+void Mouse::Configure(const Config& config) {
+    std::scoped_lock<std::mutex> lock(mutex_);
+    filter_.Configure(config);
+    decay_ = std::clamp(config.FILTER_DECAY, 0.f, 1.f);
+    dpi_scale_ = config.MOUSE_DPI > 0.f ? REFERENCE_DPI / config.MOUSE_DPI : 1.f;
+    last_mouse_change_ = {};
+    remainder_ = {};
+    last_moved_ns_ = 0;
+}
+
+void Mouse::MouseMoved(int x, int y, int center_x, int center_y, uint64_t time_ns) {
+    MouseMoved(static_cast<float>(x - center_x), static_cast<float>(y - center_y), time_ns);
+}
+
+void Mouse::MouseMoved(float delta_x, float delta_y, uint64_t time_ns) {
+    std::scoped_lock<std::mutex> lock(mutex_);
     mouse_panning_timeout_ = 0;
 
-    if (move_distance == 0) {
+    if (time_ns == 0) {
+        time_ns = Utils::now_ns();
+    }
+    /* nothing to tell how long the first movement took, it only starts the clock */
+    if (last_moved_ns_ == 0) {
+        last_moved_ns_ = time_ns;
         return;
     }
 
-    /*const auto last_move_distance = last_mouse_change.mag();
-    auto angle = std::asin(std::abs(last_mouse_change.y) / last_move_distance) * 180 / 3.141593;
-
-    auto time = angle * (angle_update_time / 90.0);*/
-    /* copied from yuzu:
-     * https://github.com/yuzu-emu/yuzu/blob/bf3c6f88126d0167329c4a18759cdabc7584f8b3/src/input_common/drivers/mouse.cpp#L74
-     */
-
-    if (move_distance < 3.0f) {
-        mouse_change /= move_distance;
-        mouse_change *= 3.0f;
+    /* a high DPI mouse or a fast poll splits the movement into fractions of a count, which the
+     * minimum distance of the filters would blow up, they're summed up until they are a step.
+     * a coalesced event may come after newer ones, its movement happened in time which was
+     * already measured and goes with the next sample */
+    const auto mouse_change = vf2d{delta_x, delta_y} * dpi_scale_ + remainder_;
+    if (mouse_change.mag() < MIN_STEP || time_ns <= last_moved_ns_) {
+        remainder_ = mouse_change;
+        return;
     }
+    remainder_ = {};
+    RMB_TRACE_STAMP(MouseMoved);
 
-    last_mouse_change_ = (last_mouse_change_ * 0.31f) + (mouse_change * 0.69f);
-
-    const auto last_move_distance = last_mouse_change_.mag();
+    const float dt = std::clamp(static_cast<float>(time_ns - last_moved_ns_) / 1e9f,
+                                MIN_SAMPLE_TIME, MAX_SAMPLE_TIME);
+    last_moved_ns_ = time_ns;
 
-    if (last_move_distance > 10.f) {
-        last_mouse_change_ /= last_move_distance;
-        last_mouse_change_ *= 10.0f;
-    }
-
-    if (last_move_distance < 1.0f) {
-        last_mouse_change_ = mouse_change / mouse_change.mag();
-    }
+    /* every raw sample goes through the filters, the ticks only decay and send the result. as a
+     * rate over the time since the last one, so the same motion in more but smaller samples
+     * moves the stick just as far */
+    last_mouse_change_ = filter_.Filter(mouse_change * (RATE_PERIOD / dt), dt);
 
 #if _DEBUG
     fprintf(stdout, "current change: %f, %f - avg change: %f, %f\n", mouse_change.x, mouse_change.y,
@@ -65,47 +90,52 @@ void Mouse::TurnTest(int delay, int test_type) {
         MouseMoved(10, 11, 11, 11);
         break;
     }
+    /* released by the key scheduler, the hot key thread doesn't sleep through the delay */
     case 1: {
-        Native::GetInstance()->SendKeysDown((uint32_t*)&Config::Current()->RIGHT_STICK_KEYS[0], 1);
-        std::this_thread::sleep_for(
-            std::chrono::duration<double, std::milli>(static_cast<double>(delay)));
-        Native::GetInstance()->SendKeysUp((uint32_t*)&Config::Current()->RIGHT_STICK_KEYS[0], 1);
-
+        KeyScheduler::GetInstance()->Tap(Config::Current()->RIGHT_STICK_KEYS[0],
+                                         std::chrono::milliseconds(delay));
         break;
     }
     case 2: {
-        Native::GetInstance()->SendKeysDown((uint32_t*)&Config::Current()->RIGHT_STICK_KEYS[2], 1);
-        std::this_thread::sleep_for(
-            std::chrono::duration<double, std::milli>(static_cast<double>(delay)));
-        Native::GetInstance()->SendKeysUp((uint32_t*)&Config::Current()->RIGHT_STICK_KEYS[2], 1);
+        KeyScheduler::GetInstance()->Tap(Config::Current()->RIGHT_STICK_KEYS[2],
+                                         std::chrono::milliseconds(delay));
         break;
     }
     }
 }
 #endif
 
-void Mouse::UpdateThread(std::stop_token stop_token) {
-    constexpr auto update_time = 10;
-
-    while (!stop_token.stop_requested()) {
-        if (Application::GetInstance()->IsPanning()) {
-            last_mouse_change_ *= 0.76f;
-
-            const float sensitivity = Config::Current()->SENSITIVITY * 0.0044f;
-            Application::GetInstance()->GetController()->SetStick(
-                last_mouse_change_.x * sensitivity,
-                                                   last_mouse_change_.y * sensitivity);
-        }
+void Mouse::Update() {
+    RMB_TRACE_TICK();
+    std::scoped_lock<std::mutex> lock(mutex_);
+    if (panning_.load(std::memory_order_acquire)) {
+        RMB_TRACE_SCOPE("Tick");
+        last_mouse_change_ *= decay_;
+        filter_.Decay(decay_);
+
+        const float sensitivity = Config::Snapshot()->SENSITIVITY * 0.0044f;
+        controller_->SetStick(last_mouse_change_.x * sensitivity,
+                              last_mouse_change_.y * sensitivity);
+    }
 
-        if (mouse_panning_timeout_++ > 15) {
-            StopPanning();
-        }
+    if (mouse_panning_timeout_++ > 15) {
+        StopPanning();
+    }
+}
 
-        std::this_thread::sleep_for(std::chrono::milliseconds(update_time));
+void Mouse::UpdateThread(std::stop_token stop_token) {
+    RMB_TRACE_THREAD("Mouse");
+    ThreadPriority::Scope priority("Mouse");
+    while (!stop_token.stop_requested()) {
+        Update();
+        std::this_thread::sleep_for(UPDATE_PERIOD);
     }
     fprintf(stdout, "Exiting Mouse.\n");
 }
 
 void Mouse::StopPanning() {
     last_mouse_change_ = {};
+    remainder_ = {};
+    last_moved_ns_ = 0;
+    filter_.Reset();
 }
\ No newline at end of file
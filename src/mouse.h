@@ -1,11 +1,37 @@
 #pragma once
+#include <atomic>
+#include <chrono>
+#include <mutex>
 #include <thread>
+#include "mouse_filter.h"
 #include "vec.h"
 
+class Config;
+class NpadController;
+
 class Mouse {
 public:
-    Mouse();
-    void MouseMoved(int x, int y, int center_x, int center_y);
+    static constexpr std::chrono::milliseconds UPDATE_PERIOD{10};
+    /* the DPI every movement is normalised to, the filters and sensitivity were tuned at it */
+    static constexpr float REFERENCE_DPI = 800.f;
+    /* normalised movement shorter than this is accumulated until it adds up */
+    static constexpr float MIN_STEP = 1.f;
+    /* the filters see the movement as counts per this period, the rate they were tuned at */
+    static constexpr float RATE_PERIOD = 0.001f;
+    /* the shortest and longest time a sample may stand for, 8000 Hz polling and a tick */
+    static constexpr float MIN_SAMPLE_TIME = 0.000125f;
+    static constexpr float MAX_SAMPLE_TIME = 0.01f;
+
+    /* without `threaded` the owner has to call `Update` every `UPDATE_PERIOD` while panning */
+    explicit Mouse(NpadController* controller, bool threaded = true);
+    /* `time_ns` is when the movement happened on the `Utils::now_ns` clock, 0 means now */
+    void MouseMoved(int x, int y, int center_x, int center_y, uint64_t time_ns = 0);
+    void MouseMoved(float delta_x, float delta_y, uint64_t time_ns = 0);
+    void SetPanning(bool value);
+    /* rebuilds the filter stages from `MouseFilter:*` and reads `Mouse:Dpi`, resets their state */
+    void Configure(const Config& config);
+    /* one update tick, feeds the smoothed movement to the controller's stick */
+    void Update();
 
 #if _DEBUG
     void TurnTest(int delay, int type);
@@ -15,6 +41,17 @@ private:
     void UpdateThread(std::stop_token stop_token);
     void StopPanning();
 
+    NpadController* controller_;
+    std::atomic_bool panning_ = false;
+    /* `MouseMoved` and `Update` may run on different threads */
+    std::mutex mutex_;
+    MouseFilter filter_;
+    float decay_ = 0.76f;
+    float dpi_scale_ = 1.f;
+    /* normalised movement which didn't reach `MIN_STEP` yet */
+    vf2d remainder_{};
+    /* of the last sample which went through the filters, 0 after a stop */
+    uint64_t last_moved_ns_ = 0;
     vf2d last_mouse_change_{};
     int mouse_panning_timeout_{};
     std::jthread update_thread;
@@ -0,0 +1,167 @@
+#include "mouse_filter.h"
+
+#include <algorithm>
+#include <cstdio>
+
+#include "Config.h"
+#include "Utils.h"
+
+static constexpr float pi = 3.14159265f;
+
+/* smoothing factor of a first order low pass at `cutoff` Hz for a sample `dt` seconds apart */
+static float LowPassAlpha(float cutoff, float dt) {
+    const float tau = 1.f / (2.f * pi * cutoff);
+    return 1.f / (1.f + tau / dt);
+}
+
+MouseFilter::MouseFilter() {
+    stages_[0].type = MouseFilterType::Yuzu;
+    stages_count_ = 1;
+}
+
+bool MouseFilter::Configure(const Config& config) {
+    ema_alpha_ = std::clamp(config.FILTER_EMA_ALPHA, 0.01f, 1.f);
+    min_cutoff_ = std::max(config.FILTER_MIN_CUTOFF, 0.01f);
+    beta_ = std::max(config.FILTER_BETA, 0.f);
+    derivative_cutoff_ = std::max(config.FILTER_DERIVATIVE_CUTOFF, 0.01f);
+    slow_alpha_ = std::clamp(config.FILTER_SLOW_ALPHA, 0.01f, 1.f);
+    fast_alpha_ = std::clamp(config.FILTER_FAST_ALPHA, 0.01f, 1.f);
+    fast_speed_ = std::max(config.FILTER_FAST_SPEED, 0.01f);
+
+    bool all_known = true;
+    stages_count_ = 0;
+    for (auto name : Utils::split_str(Utils::to_lower(config.MOUSE_FILTERS), ",")) {
+        name.erase(0, name.find_first_not_of(' '));
+        name.erase(name.find_last_not_of(' ') + 1);
+
+        MouseFilterType type;
+        if (name == "none" || name.empty()) {
+            continue;
+        }
+        else if (name == "yuzu") {
+            type = MouseFilterType::Yuzu;
+        }
+        else if (name == "ema") {
+            type = MouseFilterType::Ema;
+        }
+        else if (name == "oneeuro") {
+            type = MouseFilterType::OneEuro;
+        }
+        else if (name == "adaptive") {
+            type = MouseFilterType::Adaptive;
+        }
+        else {
+            fprintf(stderr, "Unknown mouse filter \"%s\", expected none, yuzu, ema, oneeuro or "
+                            "adaptive.\n",
+                    name.c_str());
+            all_known = false;
+            continue;
+        }
+
+        if (stages_count_ == MAX_STAGES) {
+            fprintf(stderr, "Only %zu mouse filters can be chained.\n", MAX_STAGES);
+            all_known = false;
+            break;
+        }
+        stages_[stages_count_++].type = type;
+    }
+
+    Reset();
+    return all_known;
+}
+
+vf2d MouseFilter::Filter(vf2d sample, float dt) {
+    /* two samples in the same microsecond would blow up the derivative */
+    dt = std::max(dt, 1e-6f);
+
+    for (size_t i = 0; i < stages_count_; i++) {
+        Stage& stage = stages_[i];
+        switch (stage.type) {
+        case MouseFilterType::None:
+            break;
+        case MouseFilterType::Yuzu:
+            sample = FilterYuzu(stage, sample);
+            break;
+        case MouseFilterType::Ema:
+            stage.value = stage.has_value ? Lerp(stage.value, sample, ema_alpha_) : sample;
+            sample = stage.value;
+            break;
+        case MouseFilterType::OneEuro:
+            sample = FilterOneEuro(stage, sample, dt);
+            break;
+        case MouseFilterType::Adaptive: {
+            const float speed = std::min(sample.mag() / fast_speed_, 1.f);
+            const float alpha = slow_alpha_ + (fast_alpha_ - slow_alpha_) * speed;
+            stage.value = stage.has_value ? Lerp(stage.value, sample, alpha) : sample;
+            sample = stage.value;
+            break;
+        }
+        }
+        stage.has_value = true;
+    }
+    return sample;
+}
+
+void MouseFilter::Decay(float factor) {
+    for (size_t i = 0; i < stages_count_; i++) {
+        stages_[i].value *= factor;
+    }
+}
+
+void MouseFilter::Reset() {
+    for (size_t i = 0; i < stages_count_; i++) {
+        stages_[i] = {stages_[i].type, false, {}, {}, {}};
+    }
+}
+
+/* copied from yuzu:
+ * https://github.com/yuzu-emu/yuzu/blob/bf3c6f88126d0167329c4a18759cdabc7584f8b3/src/input_common/drivers/mouse.cpp#L74
+ */
+vf2d MouseFilter::FilterYuzu(Stage& stage, vf2d sample) {
+    const auto move_distance = sample.mag();
+    if (move_distance == 0) {
+        return stage.value;
+    }
+
+    if (move_distance < 3.0f) {
+        sample /= move_distance;
+        sample *= 3.0f;
+    }
+
+    stage.value = (stage.value * 0.31f) + (sample * 0.69f);
+
+    const auto last_move_distance = stage.value.mag();
+
+    if (last_move_distance > 10.f) {
+        stage.value /= last_move_distance;
+        stage.value *= 10.0f;
+    }
+
+    if (last_move_distance < 1.0f) {
+        stage.value = sample / sample.mag();
+    }
+    return stage.value;
+}
+
+/* https://gery.casiez.net/1euro/, the cutoff rises with the speed the samples change at so slow
+ * movements get smoothed and flicks go through without lag */
+vf2d MouseFilter::FilterOneEuro(Stage& stage, vf2d sample, float dt) {
+    if (!stage.has_value) {
+        stage.value = sample;
+        stage.last_sample = sample;
+        stage.derivative = {};
+        return sample;
+    }
+
+    const vf2d derivative = (sample - stage.last_sample) / dt;
+    stage.derivative =
+        Lerp(stage.derivative, derivative, LowPassAlpha(derivative_cutoff_, dt));
+    const float cutoff = min_cutoff_ + beta_ * stage.derivative.mag();
+    stage.value = Lerp(stage.value, sample, LowPassAlpha(cutoff, dt));
+    stage.last_sample = sample;
+    return stage.value;
+}
+
+vf2d MouseFilter::Lerp(vf2d from, vf2d to, float alpha) {
+    return from + (to - from) * alpha;
+}
\ No newline at end of file
@@ -0,0 +1,65 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "vec.h"
+
+class Config;
+
+enum class MouseFilterType : uint8_t {
+    None,
+    /* minimum distance of 3, 0.31/0.69 EMA and a clamp at 10, copied from yuzu */
+    Yuzu,
+    Ema,
+    OneEuro,
+    /* EMA which follows faster the faster the mouse moves */
+    Adaptive,
+};
+
+/* Chain of smoothing stages which runs on every raw mouse sample, configured from the
+ * `MouseFilter:*` options. Fixed size, nothing is allocated after `Configure`. */
+class MouseFilter {
+public:
+    static constexpr size_t MAX_STAGES = 4;
+
+    MouseFilter();
+
+    /* unknown stages are skipped, returns false if there was any */
+    bool Configure(const Config& config);
+
+    /* `dt` is the time since the previous sample in seconds */
+    vf2d Filter(vf2d sample, float dt);
+    /* scales every stage's state, called on each tick while the mouse doesn't move */
+    void Decay(float factor);
+    void Reset();
+
+    size_t GetStagesCount() const {
+        return stages_count_;
+    }
+
+private:
+    struct Stage {
+        MouseFilterType type;
+        bool has_value;
+        vf2d value;
+        vf2d last_sample;
+        vf2d derivative;
+    };
+
+    vf2d FilterYuzu(Stage& stage, vf2d sample);
+    vf2d FilterOneEuro(Stage& stage, vf2d sample, float dt);
+    static vf2d Lerp(vf2d from, vf2d to, float alpha);
+
+    Stage stages_[MAX_STAGES]{};
+    size_t stages_count_ = 0;
+
+    float ema_alpha_ = 0.69f;
+    float min_cutoff_ = 1.0f;
+    float beta_ = 0.05f;
+    float derivative_cutoff_ = 1.0f;
+    float slow_alpha_ = 0.2f;
+    float fast_alpha_ = 0.9f;
+    float fast_speed_ = 20.f;
+};
\ No newline at end of file
@@ -13,6 +13,8 @@
 
 #include "EventSystem.h"
 
+class VirtualGamepad;
+
 struct HotkeyEvent : Event {
     HotkeyEvent(uint32_t key, uint32_t modifier) : key(key), modifier(modifier){};
     uint32_t key;
@@ -28,9 +30,43 @@ struct MouseButtonEvent : Event {
     int y;
 };
 
+/* relative device motion, only published by platforms where `Native::HasRawMouseMotion` is true */
+struct MouseMotionEvent : Event {
+    MouseMotionEvent(float dx, float dy) : dx(dx), dy(dy){};
+    /* lets the deferred queue coalesce motion when it is full, it's as new as the newest part */
+    void Merge(const MouseMotionEvent& other) {
+        dx += other.dx;
+        dy += other.dy;
+        if (other.published_ns > published_ns)
+            published_ns = other.published_ns;
+    }
+    float dx;
+    float dy;
+};
+
+/* the focused window or its name changed, only published by platforms which track it */
+struct FocusChangedEvent : Event {
+    FocusChangedEvent(std::string window_class, std::string window_title)
+        : window_class(std::move(window_class)), window_title(std::move(window_title)){};
+    std::string window_class;
+    std::string window_title;
+};
+
 const uint32_t MOUSE_LBUTTON = 0x1;
 const uint32_t MOUSE_RBUTTON = 0x2;
 const uint32_t MOUSE_MBUTTON = 0x3;
+/* every wheel tick is published as a press on its own, without a release */
+const uint32_t MOUSE_WHEEL_UP = 0x4;
+const uint32_t MOUSE_WHEEL_DOWN = 0x5;
+const uint32_t MOUSE_WHEEL_LEFT = 0x6;
+const uint32_t MOUSE_WHEEL_RIGHT = 0x7;
+/* side buttons, usually back and forward */
+const uint32_t MOUSE_XBUTTON1 = 0x8;
+const uint32_t MOUSE_XBUTTON2 = 0x9;
+
+inline bool IsMouseWheel(uint32_t button) {
+    return button >= MOUSE_WHEEL_UP && button <= MOUSE_WHEEL_RIGHT;
+}
 
 #ifdef _WIN32
 using NativeWindow = void*;
@@ -93,6 +129,18 @@ public:
     /* (0, 0) should be at the top left corner of the main monitor/screen */
     virtual void SetMousePos(int x, int y) = 0;
     virtual void GetMousePos(int* x_ret, int* y_ret) = 0;
+    /* optional, size of the main monitor/screen when there is no GLFW to ask */
+    virtual bool GetScreenSize(int* width, int* height) {
+        (void)width;
+        (void)height;
+        return false;
+    }
+    /* optional, scan code of a GLFW key code (what `RMB.ini` stores) without initializing GLFW,
+     * -1 if the key isn't known */
+    virtual int GetKeyScancode(int key) {
+        (void)key;
+        return -1;
+    }
 
     /* optional */
     virtual NativeWindow GetFocusedWindow() = 0;
@@ -103,6 +151,39 @@ public:
 
     virtual void CursorHide(bool hide) = 0;
 
+    /* optional, when true `MouseMotionEvent`s are published as the device moves and
+     * `GetMousePos` doesn't need to be polled for detecting movement */
+    virtual bool HasRawMouseMotion() {
+        return false;
+    }
+    /* optional, keeps the cursor inside a small area around (x, y) so it doesn't have to be warped
+     * back on every move, only makes sense together with raw mouse motion */
+    virtual bool ConfinePointer(int x, int y) {
+        (void)x;
+        (void)y;
+        return false;
+    }
+    virtual void ReleasePointer() {}
+    /* optional, returns nullptr if the platform can't create a virtual controller */
+    virtual VirtualGamepad* GetVirtualGamepad() {
+        return nullptr;
+    }
+
+    /* optional, fills `fds` with the file descriptors which become readable when `Update` has
+     * input to read and moves all of the input reading into `Update`, so the caller can sleep on
+     * them instead of polling. returns 0 if `Update` has to be polled */
+    virtual size_t UseEventLoop(int* fds, size_t max_fds) {
+        (void)fds;
+        (void)max_fds;
+        return 0;
+    }
+
+    /* optional, with `UseEventLoop` true when input was already read off the fds and is waiting
+     * for `Update`, so the fds won't wake the caller for it */
+    virtual bool HasPendingEvents() {
+        return false;
+    }
+
     /* should not block the current thread */
     virtual void Update() = 0;
 };
\ No newline at end of file
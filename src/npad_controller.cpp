@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <cmath>
 #include <deque>
 #include <stdint.h>
@@ -6,8 +7,12 @@
 #include <bitset>
 #include "Application.h"
 #include "Config.h"
+#include "Tracer.h"
 #include "Utils.h"
+#include "key_scheduler.h"
 #include "keyboard_manager.h"
+#include "native.h"
+#include "virtual_gamepad.h"
 
 #ifndef _WIN32
 #include <string.h>
@@ -15,8 +20,6 @@
 
 constexpr int BUTTONS = 4;
 
-constexpr int32_t HID_JOYSTICK_MAX = 0x7fff;
-
 struct StickStatus {
     int32_t x;
     int32_t y;
@@ -29,11 +32,14 @@ struct ButtonStatus {
 
 class StickInputHandler {
 public:
-    inline void OnChange(const StickStatus& status) {
+    /* `keys` are left, right, up and down, the ones below 0 are skipped */
+    inline void OnChange(size_t output, const StickStatus& status, const int* keys,
+                         bool pulse_width) {
+        uint32_t* timeouts = timeouts_[output];
         auto value_x = status.x;
         auto value_y = status.y;
 
-        DEBUG_OUT("stick change: %d, %d\n", value_x, value_y);
+        DEBUG_OUT("stick %zu change: %d, %d\n", output, value_x, value_y);
 
         auto new_time_x = static_cast<uint32_t>(std::abs(value_x));
         auto new_time_y = static_cast<uint32_t>(std::abs(value_y));
@@ -44,82 +50,365 @@ public:
         auto button_y = (1 * 2) + (Utils::sign(value_y) > 0);
         auto opposite_button_y = 5 - button_y;
 
+        if (pulse_width) {
+            timeouts[opposite_button_x] = 0;
+            timeouts[opposite_button_y] = 0;
+            timeouts[button_x] = new_time_x;
+            timeouts[button_y] = new_time_y;
+            /* the scheduler holds each key for the part of the period the stick is pushed */
+            for (int i = 0; i < BUTTONS; i++) {
+                if (keys[i] < 0)
+                    continue;
+                const float duty =
+                    static_cast<float>(timeouts[i]) / static_cast<float>(HID_JOYSTICK_MAX);
+                KeyScheduler::GetInstance()->SetDuty(keys[i], duty);
+            }
+            return;
+        }
+
         if (new_time_x == 0) {
-            KeyboardManager::GetInstance()->SendKeyUp(Config::Current()->RIGHT_STICK_KEYS[button_x]);
+            SendKeyUp(keys[button_x]);
         }
-        else if (timeouts_[button_x] == 0) {
-            KeyboardManager::GetInstance()->SendKeyDown(Config::Current()->RIGHT_STICK_KEYS[button_x]);
+        else if (timeouts[button_x] == 0) {
+            SendKeyDown(keys[button_x]);
         }
 
-        if (timeouts_[opposite_button_x])
-            KeyboardManager::GetInstance()->SendKeyUp(Config::Current()->RIGHT_STICK_KEYS[opposite_button_x]);
+        if (timeouts[opposite_button_x])
+            SendKeyUp(keys[opposite_button_x]);
 
         if (new_time_y == 0) {
-            KeyboardManager::GetInstance()->SendKeyUp(Config::Current()->RIGHT_STICK_KEYS[button_y]);
+            SendKeyUp(keys[button_y]);
         }
-        else if (timeouts_[button_y] == 0) {
-            KeyboardManager::GetInstance()->SendKeyDown(Config::Current()->RIGHT_STICK_KEYS[button_y]);
+        else if (timeouts[button_y] == 0) {
+            SendKeyDown(keys[button_y]);
         }
 
-        if (timeouts_[opposite_button_y])
-            KeyboardManager::GetInstance()->SendKeyUp(Config::Current()->RIGHT_STICK_KEYS[opposite_button_y]);
+        if (timeouts[opposite_button_y])
+            SendKeyUp(keys[opposite_button_y]);
 
-        timeouts_[opposite_button_x] = 0;
-        timeouts_[opposite_button_y] = 0;
-        timeouts_[button_x] = new_time_x;
-        timeouts_[button_y] = new_time_y;
+        timeouts[opposite_button_x] = 0;
+        timeouts[opposite_button_y] = 0;
+        timeouts[button_x] = new_time_x;
+        timeouts[button_y] = new_time_y;
     }
 
     inline void Clear() {
-        memset(timeouts_, 0, sizeof(uint32_t) * BUTTONS);
+        memset(timeouts_, 0, sizeof(timeouts_));
+        if (pulse_width_mode_) {
+            KeyScheduler::GetInstance()->ReleaseChannels();
+        }
+    }
+
+    inline void SetPulseWidthMode(bool value) {
+        if (pulse_width_mode_ && !value) {
+            KeyScheduler::GetInstance()->ReleaseChannels();
+        }
+        pulse_width_mode_ = value;
+    }
+
+    inline bool IsPulseWidthMode() const {
+        return pulse_width_mode_;
     }
-    
+
 private:
-    uint32_t timeouts_[BUTTONS]{0};
+    static inline void SendKeyDown(int key) {
+        if (key >= 0)
+            KeyboardManager::GetInstance()->SendKeyDown(key);
+    }
+
+    static inline void SendKeyUp(int key) {
+        if (key >= 0)
+            KeyboardManager::GetInstance()->SendKeyUp(key);
+    }
+
+    uint32_t timeouts_[CONTROLLER_OUTPUTS][BUTTONS]{};
+    bool pulse_width_mode_ = false;
 };
 
+/* keys of each `ControllerOutput` in `config` */
+static void GetOutputKeys(const Config& config, const int* (&keys)[CONTROLLER_OUTPUTS]) {
+    keys[static_cast<size_t>(ControllerOutput::LeftStick)] = config.LEFT_STICK_KEYS;
+    keys[static_cast<size_t>(ControllerOutput::RightStick)] = config.RIGHT_STICK_KEYS;
+    keys[static_cast<size_t>(ControllerOutput::DPad)] = config.DPAD_KEYS;
+}
+
+static_assert(CONTROLLER_OUTPUTS == Config::OUTPUTS);
+static_assert(CONTROLLER_SOURCES <= 32, "`used_sources_` has a bit per source");
+
+constexpr size_t BUTTON_OUTPUT = static_cast<size_t>(ControllerOutput::Button);
+constexpr size_t BUTTON_SOURCE = static_cast<size_t>(ControllerSource::LeftButton);
+/* in `ControllerSource` order */
+static constexpr const char* SOURCE_NAMES[CONTROLLER_SOURCES] = {
+    "none",      "mouse",     "wheel",      "leftbutton", "rightbutton", "middlebutton",
+    "wheelup",   "wheeldown", "wheelleft",  "wheelright", "backbutton",  "forwardbutton"};
+
+static ControllerSource ParseSource(const std::string& source) {
+    const std::string name = Utils::to_lower(source);
+    for (size_t i = 0; i < CONTROLLER_SOURCES; i++) {
+        if (name == SOURCE_NAMES[i])
+            return static_cast<ControllerSource>(i);
+    }
+    if (!name.empty()) {
+        fprintf(stderr,
+                "Unknown controller source \"%s\", expected none, mouse, wheel or a mouse "
+                "button.\n",
+                source.c_str());
+    }
+    return ControllerSource::None;
+}
+
+/* "up", "down", "left" or "right", anything else is any way */
+static void ParseDirection(const std::string& direction, float& x, float& y) {
+    const std::string name = Utils::to_lower(direction);
+    x = name == "left" ? -1.f : name == "right" ? 1.f : 0.f;
+    y = name == "up" ? -1.f : name == "down" ? 1.f : 0.f;
+    if (!name.empty() && x == 0.f && y == 0.f) {
+        fprintf(stderr, "Unknown direction \"%s\", expected up, down, left or right.\n",
+                direction.c_str());
+    }
+}
+
+static bool IsButtonSource(ControllerSource source) {
+    return static_cast<size_t>(source) >= BUTTON_SOURCE;
+}
+
+/* `MOUSE_LBUTTON` to `MOUSE_XBUTTON2`, `ControllerSource::None` for anything else */
+static ControllerSource GetButtonSource(uint32_t mouse_button) {
+    if (mouse_button < MOUSE_LBUTTON || mouse_button > MOUSE_XBUTTON2)
+        return ControllerSource::None;
+    return static_cast<ControllerSource>(BUTTON_SOURCE + mouse_button - MOUSE_LBUTTON);
+}
+
+/* the bits of `used_sources_` a mouse button moves, a wheel notch moves the wheel source too */
+static uint32_t GetSourceBits(uint32_t mouse_button) {
+    const ControllerSource source = GetButtonSource(mouse_button);
+    if (source == ControllerSource::None)
+        return 0;
+    uint32_t bits = 1u << static_cast<uint32_t>(source);
+    if (IsMouseWheel(mouse_button))
+        bits |= 1u << static_cast<uint32_t>(ControllerSource::Wheel);
+    return bits;
+}
+
 NpadController::NpadController()
     : stick_handler_(new StickInputHandler()) {
 }
 
+/* runs on the scheduler thread, the controller cancels its taps before it goes away */
+static void SendGamepadTap(void* controller, uint32_t button, bool is_down) {
+    static_cast<NpadController*>(controller)->SetGamepadButton(button, is_down);
+}
+
+static void SendSourceTap(void* controller, uint32_t mouse_button, bool is_down) {
+    static_cast<NpadController*>(controller)->SetSourceButton(mouse_button, is_down);
+}
+
 NpadController::~NpadController() {
+    if (has_taps_)
+        KeyScheduler::GetInstance()->CancelTaps(this);
     ClearState();
     delete stick_handler_;
 
     fprintf(stdout, "Exiting Controller.\n");
 }
 
+void NpadController::Configure(const Config& config) {
+    std::scoped_lock<std::mutex> lock{mutex};
+    curve_.Bake(config);
+
+    x_offset_ = config.X_OFFSET;
+    y_offset_ = config.Y_OFFSET;
+    /* large offsets are applied as they are */
+    const bool scale_x = std::abs(x_offset_) < 0.75f;
+    const bool scale_y = std::abs(y_offset_) < 0.75f;
+    x_scale_[0] = scale_x ? 1.f / (1 - x_offset_) : 1.f;
+    x_scale_[1] = scale_x ? 1.f / (1 + x_offset_) : 1.f;
+    y_scale_[0] = scale_y ? 1.f / (1 - y_offset_) : 1.f;
+    y_scale_[1] = scale_y ? 1.f / (1 + y_offset_) : 1.f;
+
+    /* the keys and buttons may change, the pressed ones are let go with the old ones. a mouse
+     * button held through the change has to be pressed again */
+    ReleaseButtons();
+    memset(source_pressed_, 0, sizeof(source_pressed_));
+
+    bool source_removed = false;
+    used_sources_ = 0;
+    for (size_t i = 0; i < CONTROLLER_OUTPUTS; i++) {
+        const ControllerSource source = ParseSource(config.OUTPUT_SOURCES[i]);
+        source_removed |= source == ControllerSource::None && outputs_.source[i] != source;
+        outputs_.source[i] = source;
+        used_sources_ |= 1u << static_cast<uint32_t>(source);
+        const float deadzone = std::clamp(config.OUTPUT_DEADZONES[i], 0.f, 1.f);
+        outputs_.deadzone2[i] = deadzone * deadzone;
+        outputs_.threshold[i] = std::clamp(config.OUTPUT_THRESHOLDS[i], 0.f, 1.f);
+
+        float& direction_x = outputs_.direction_x[i];
+        float& direction_y = outputs_.direction_y[i];
+        ParseDirection(config.OUTPUT_DIRECTIONS[i], direction_x, direction_y);
+        /* a mouse button pushes a stick up unless it's told otherwise */
+        if (i < BUTTON_OUTPUT && direction_x == 0.f && direction_y == 0.f)
+            direction_y = -1.f;
+
+        if (i >= BUTTON_OUTPUT) {
+            outputs_.key[i] = config.BUTTON_KEYS[i - BUTTON_OUTPUT];
+            outputs_.pad_button[i] = config.BUTTON_PAD_BUTTONS[i - BUTTON_OUTPUT];
+        }
+    }
+
+    /* nothing moves that output anymore, whatever it holds has to be let go */
+    if (source_removed) {
+        for (size_t i = 0; i < CONTROLLER_OUTPUTS; i++) {
+            outputs_.x[i] = outputs_.y[i] = 0;
+        }
+        stick_handler_->Clear();
+        KeyboardManager::GetInstance()->Clear();
+        ResetGamepad();
+    }
+
+    /* what the released buttons held goes back with the new sources right away, an idle mouse
+     * wouldn't get `SetStick` through. the next one goes through the new curve even if the
+     * mouse didn't change */
+    UpdateOutputs();
+    last_raw_x_ = last_raw_y_ = 0.f;
+}
+
 /* There should be one thread calling this function at a time... */
 void NpadController::SetStick(float raw_x, float raw_y) {
     std::scoped_lock<std::mutex> lock{mutex};
     if (last_raw_x_ == raw_x && last_raw_y_ == raw_y) {
         return;
     }
+    RMB_TRACE_STAMP(SetStick);
 
     DEBUG_OUT("new change: %f, %f\n", raw_x, raw_y);
 
     last_raw_x_ = raw_x;
     last_raw_y_ = raw_y;
 
-    SanatizeAxes(last_raw_x_, last_raw_y_, true);
+    SanatizeAxes(last_raw_x_, last_raw_y_);
+    UpdateOutputs();
+}
+
+/* `sources_x/y` are indexed by `ControllerSource`, the button sources are pressed or not */
+void NpadController::UpdateOutputs() {
+    const auto wheel = [this](ControllerSource source) {
+        return source_pressed_[static_cast<size_t>(source)] ? 1.f : 0.f;
+    };
+    const float sources_x[BUTTON_SOURCE] = {
+        0.f, last_x_, wheel(ControllerSource::WheelRight) - wheel(ControllerSource::WheelLeft)};
+    const float sources_y[BUTTON_SOURCE] = {
+        0.f, last_y_, wheel(ControllerSource::WheelDown) - wheel(ControllerSource::WheelUp)};
+    constexpr size_t dpad = static_cast<size_t>(ControllerOutput::DPad);
+    constexpr float max = static_cast<float>(HID_JOYSTICK_MAX);
+
+    for (size_t i = 0; i < CONTROLLER_OUTPUTS; i++) {
+        const ControllerSource source = outputs_.source[i];
+        const float threshold = outputs_.threshold[i];
+        float x = 0.f;
+        float y = 0.f;
+        if (IsButtonSource(source)) {
+            const bool pressed = source_pressed_[static_cast<size_t>(source)];
+            if (i >= BUTTON_OUTPUT) {
+                if (pressed != outputs_.pressed[i])
+                    SendButton(i, outputs_.pressed[i] = pressed);
+                continue;
+            }
+            x = pressed ? outputs_.direction_x[i] : 0.f;
+            y = pressed ? outputs_.direction_y[i] : 0.f;
+        }
+        else {
+            x = sources_x[static_cast<size_t>(source)];
+            y = sources_y[static_cast<size_t>(source)];
+        }
+        if (x * x + y * y <= outputs_.deadzone2[i]) {
+            x = y = 0.f;
+        }
 
-    auto new_x = std::roundf(last_x_ * static_cast<float>(HID_JOYSTICK_MAX));
-    auto new_y = std::roundf(last_y_ * static_cast<float>(HID_JOYSTICK_MAX));
+        if (i >= BUTTON_OUTPUT) {
+            const float direction_x = outputs_.direction_x[i];
+            const float direction_y = outputs_.direction_y[i];
+            /* past the threshold along the direction, or any way without one */
+            const bool pressed = direction_x == 0.f && direction_y == 0.f
+                                     ? x * x + y * y > threshold * threshold
+                                     : x * direction_x + y * direction_y > threshold;
+            if (source != ControllerSource::None && pressed != outputs_.pressed[i])
+                SendButton(i, outputs_.pressed[i] = pressed);
+            continue;
+        }
 
-    stick_handler_->OnChange({static_cast<int32_t>(new_x), static_cast<int32_t>(new_y)});
+        if (i == dpad) {
+            x = std::abs(x) > threshold ? static_cast<float>(Utils::sign(x)) : 0.f;
+            y = std::abs(y) > threshold ? static_cast<float>(Utils::sign(y)) : 0.f;
+        }
+        else if (threshold > 0.f) {
+            x = std::abs(x) >= threshold ? x : 0.f;
+            y = std::abs(y) >= threshold ? y : 0.f;
+        }
+        outputs_.x[i] = static_cast<int32_t>(std::roundf(x * max));
+        outputs_.y[i] = static_cast<int32_t>(std::roundf(y * max));
+    }
 
-    axes_.x = new_x;
-    axes_.y = new_y;
+    if (gamepad_) {
+        for (size_t i = 0; i < BUTTON_OUTPUT; i++) {
+            if (outputs_.source[i] == ControllerSource::None)
+                continue;
+            if (i == dpad) {
+                gamepad_->SetDPad(Utils::sign(outputs_.x[i]), Utils::sign(outputs_.y[i]));
+            }
+            else {
+                gamepad_->SetStick(static_cast<GamepadStick>(i), outputs_.x[i], outputs_.y[i]);
+            }
+        }
+        gamepad_->Flush();
+        return;
+    }
 
-    axes_.right = last_x_ > Config::Current()->THRESHOLD;
-    axes_.left = last_x_ < -Config::Current()->THRESHOLD;
-    axes_.up = last_y_ > Config::Current()->THRESHOLD;
-    axes_.down = last_y_ < -Config::Current()->THRESHOLD;
+    /* one snapshot for the whole pass, the keys can't change halfway through */
+    const auto config = Config::Snapshot();
+    const int* keys[CONTROLLER_OUTPUTS];
+    GetOutputKeys(*config, keys);
+    for (size_t i = 0; i < BUTTON_OUTPUT; i++) {
+        if (outputs_.source[i] == ControllerSource::None)
+            continue;
+        /* a D-pad direction is either pressed or not, there is nothing to modulate */
+        const bool pulse_width = stick_handler_->IsPulseWidthMode() && i != dpad;
+        stick_handler_->OnChange(i, {outputs_.x[i], outputs_.y[i]}, keys[i], pulse_width);
+    }
+}
 
-    DEBUG_OUT_COND(axes_.x != 0 || axes_.y != 0, "axes_change: %f, %f - actual_value: %f, %f\n",
-                   axes_.x, axes_.y, last_x_, last_y_);
-    DEBUG_OUT_COND(axes_.x != 0 || axes_.y != 0, "right: %d left: %d up: %d down: %d\n",
-                   axes_.right, axes_.left, axes_.up, axes_.down);
+/* the buttons send right away, the sticks and D-pad are flushed together by `UpdateOutputs` */
+void NpadController::SendButton(size_t output, bool pressed) {
+    if (gamepad_) {
+        if (outputs_.pad_button[output] >= 0)
+            gamepad_->SetButton(static_cast<GamepadButton>(outputs_.pad_button[output]), pressed);
+    }
+    else if (outputs_.key[output] >= 0) {
+        SetButton(static_cast<uint32_t>(outputs_.key[output]), pressed);
+    }
+}
+
+void NpadController::ReleaseButtons() {
+    for (size_t i = BUTTON_OUTPUT; i < CONTROLLER_OUTPUTS; i++) {
+        if (outputs_.pressed[i])
+            SendButton(i, outputs_.pressed[i] = false);
+    }
+    if (gamepad_)
+        gamepad_->Flush();
+}
+
+bool NpadController::HasOutputKeys(const Config& config) {
+    std::scoped_lock<std::mutex> lock{mutex};
+    const int* keys[CONTROLLER_OUTPUTS];
+    GetOutputKeys(config, keys);
+    for (size_t i = 0; i < BUTTON_OUTPUT; i++) {
+        if (outputs_.source[i] == ControllerSource::None)
+            continue;
+        for (int j = 0; j < BUTTONS; j++) {
+            if (keys[i][j] < 0)
+                return false;
+        }
+    }
+    return true;
 }
 
 void NpadController::SetButton(uint32_t button, int value) {
@@ -131,19 +420,120 @@ void NpadController::SetButton(uint32_t button, int value) {
     }
 }
 
+void NpadController::SetGamepadButton(uint32_t button, int value) {
+    std::scoped_lock<std::mutex> lock{mutex};
+    if (!gamepad_) {
+        return;
+    }
+    gamepad_->SetButton(static_cast<GamepadButton>(button), value != 0);
+    gamepad_->Flush();
+}
+
+static std::chrono::microseconds ToMicroseconds(float ms) {
+    return std::chrono::microseconds(static_cast<int64_t>(std::max(ms, 1.f) * 1000.f));
+}
+
+void NpadController::TapButton(uint32_t button, float duration_ms) {
+    KeyScheduler::GetInstance()->Tap(button, ToMicroseconds(duration_ms));
+}
+
+void NpadController::TapGamepadButton(uint32_t button, float duration_ms) {
+    has_taps_ = true;
+    KeyScheduler::GetInstance()->Tap(button, ToMicroseconds(duration_ms), SendGamepadTap, this);
+}
+
+bool NpadController::SetSourceButton(uint32_t mouse_button, bool pressed) {
+    std::scoped_lock<std::mutex> lock{mutex};
+    if (!(used_sources_ & GetSourceBits(mouse_button)))
+        return false;
+    source_pressed_[static_cast<size_t>(GetButtonSource(mouse_button))] = pressed;
+    UpdateOutputs();
+    return true;
+}
+
+bool NpadController::TapSourceButton(uint32_t mouse_button, float duration_ms) {
+    {
+        std::scoped_lock<std::mutex> lock{mutex};
+        if (!(used_sources_ & GetSourceBits(mouse_button)))
+            return false;
+    }
+    has_taps_ = true;
+    KeyScheduler::GetInstance()->Tap(mouse_button, ToMicroseconds(duration_ms), SendSourceTap,
+                                     this);
+    return true;
+}
+
+void NpadController::PlayMacro(const ConfigMacro& macro, bool repeat) {
+    KeyScheduler::MacroEvent events[KeyScheduler::MAX_MACRO_EVENTS];
+    size_t count = 0;
+    for (const MacroStep& step : macro.STEPS) {
+        if (count == KeyScheduler::MAX_MACRO_EVENTS)
+            break;
+        if (step.KEY < 0)
+            continue;
+        events[count++] = {std::chrono::microseconds(static_cast<int64_t>(step.OFFSET * 1000.f)),
+                           static_cast<uint32_t>(step.KEY), step.IS_DOWN};
+    }
+
+    const auto period = std::chrono::microseconds(
+        repeat ? static_cast<int64_t>(macro.REPEAT * 1000.f) : 0);
+    /* a trigger has at most one macro */
+    KeyScheduler::GetInstance()->PlayMacro(macro.TRIGGER, events, count, period);
+}
+
+void NpadController::StopMacro(const ConfigMacro& macro) {
+    KeyScheduler::GetInstance()->StopMacro(macro.TRIGGER);
+}
+
 void NpadController::SetPersistentMode(bool value) {
     KeyboardManager::GetInstance()->SetPersistentMode(value);
 }
 
+void NpadController::SetPulseWidthMode(bool value, float period_ms) {
+    std::scoped_lock<std::mutex> lock{mutex};
+    KeyScheduler::GetInstance()->SetPeriod(std::chrono::microseconds(
+        static_cast<int64_t>(period_ms * 1000.f)));
+    stick_handler_->SetPulseWidthMode(value);
+}
+
+bool NpadController::SetVirtualGamepadMode(bool value) {
+    std::scoped_lock<std::mutex> lock{mutex};
+    ReleaseButtons();
+    ResetGamepad();
+    gamepad_ = value ? Native::GetInstance()->GetVirtualGamepad() : nullptr;
+    return gamepad_ != nullptr || !value;
+}
+
 void NpadController::ClearState() {
+    /* the mouse thread may be inside `SetStick` */
+    std::scoped_lock<std::mutex> lock{mutex};
     last_raw_x_ = last_raw_y_ = last_x_ = last_y_ = 0.f;
-    axes_ = {};
+    memset(source_pressed_, 0, sizeof(source_pressed_));
+    for (size_t i = 0; i < CONTROLLER_OUTPUTS; i++) {
+        outputs_.x[i] = outputs_.y[i] = 0;
+        outputs_.pressed[i] = false;
+    }
 
     stick_handler_->Clear();
     KeyboardManager::GetInstance()->Clear();
+    ResetGamepad();
 }
 
-void NpadController::SanatizeAxes(float raw_x, float raw_y, bool clamp_value) {
+void NpadController::ResetGamepad() {
+    if (!gamepad_)
+        return;
+
+    for (size_t i = 0; i < static_cast<size_t>(GamepadStick::Count); i++) {
+        gamepad_->SetStick(static_cast<GamepadStick>(i), 0, 0);
+    }
+    gamepad_->SetDPad(0, 0);
+    for (uint32_t i = 0; i < static_cast<uint32_t>(GamepadButton::Count); i++) {
+        gamepad_->SetButton(static_cast<GamepadButton>(i), false);
+    }
+    gamepad_->Flush();
+}
+
+void NpadController::SanatizeAxes(float raw_x, float raw_y) {
     float& x = last_x_;
     float& y = last_y_;
 
@@ -154,47 +544,13 @@ void NpadController::SanatizeAxes(float raw_x, float raw_y, bool clamp_value) {
         raw_y = 0;
     }
 
-    raw_x += Config::Current()->X_OFFSET;
-    raw_y += Config::Current()->Y_OFFSET;
-
-    if (std::abs(Config::Current()->X_OFFSET) < 0.75f) {
-        if (raw_x > 0) {
-            raw_x /= 1 + Config::Current()->X_OFFSET;
-        }
-        else {
-            raw_x /= 1 - Config::Current()->X_OFFSET;
-        }
-    }
-
-    if (std::abs(Config::Current()->Y_OFFSET) < 0.75f) {
-        if (raw_y > 0) {
-            raw_y /= 1 + Config::Current()->Y_OFFSET;
-        }
-        else {
-            raw_y /= 1 - Config::Current()->Y_OFFSET;
-        }
-    }
+    raw_x += x_offset_;
+    raw_y += y_offset_;
+    x = raw_x * x_scale_[raw_x > 0];
+    y = raw_y * y_scale_[raw_y > 0];
 
-    x = raw_x;
-    y = raw_y;
-
-    float r = x * x + y * y;
-    r = std::sqrt(r);
-
-    if (r <= Config::Current()->DEADZONE || Config::Current()->DEADZONE >= 1.0f) {
-        x = 0;
-        y = 0;
-        return;
-    }
-
-    const float deadzone_factor =
-        1.0f / r * (r - Config::Current()->DEADZONE) / (1.0f - Config::Current()->DEADZONE);
-    x = x * deadzone_factor / Config::Current()->RANGE;
-    y = y * deadzone_factor / Config::Current()->RANGE;
-    r = r * deadzone_factor / Config::Current()->RANGE;
-
-    if (clamp_value && r > 1.0f) {
-        x /= r;
-        y /= r;
-    }
+    /* deadzone, curve, range and the clamp to the unit circle in one lookup */
+    const float scale = curve_.GetScale(x * x + y * y);
+    x *= scale;
+    y *= scale;
 }
\ No newline at end of file
@@ -1,32 +1,121 @@
 #pragma once
+#include <atomic>
+#include <cstdint>
 #include <mutex>
+#include "response_curve.h"
+#include "virtual_gamepad.h"
 
-struct Axes {
-    float x;
-    float y;
+constexpr uint32_t CONTROLLER_BUTTONS = 8;
 
-    bool left;
-    bool right;
-    bool up;
-    bool down;
+/* everything a source can be mapped to, each has its own keys, deadzone and threshold */
+enum class ControllerOutput : uint32_t {
+    LeftStick,
+    RightStick,
+    /* digital, a direction is pressed while its axis is past the threshold */
+    DPad,
+    /* the first of the `CONTROLLER_BUTTONS` buttons, each presses a key or a gamepad button */
+    Button,
+    Count = Button + CONTROLLER_BUTTONS,
 };
 
+enum class ControllerSource : uint8_t {
+    None,
+    /* the filtered mouse movement after the response curve */
+    Mouse,
+    /* right minus left and down minus up of the wheel notches which are held right now */
+    Wheel,
+    /* pressed or released, the mouse buttons from `MOUSE_LBUTTON` to `MOUSE_XBUTTON2` in order.
+     * a wheel notch holds its button for `Mouse:WheelTapDuration` */
+    LeftButton,
+    RightButton,
+    MiddleButton,
+    WheelUp,
+    WheelDown,
+    WheelLeft,
+    WheelRight,
+    BackButton,
+    ForwardButton,
+    Count,
+};
+
+constexpr size_t CONTROLLER_OUTPUTS = static_cast<size_t>(ControllerOutput::Count);
+constexpr size_t CONTROLLER_SOURCES = static_cast<size_t>(ControllerSource::Count);
+
+/* one column per `ControllerOutput`, a single pass over them turns the sources into every output */
+struct ControllerOutputs {
+    ControllerSource source[CONTROLLER_OUTPUTS]{};
+    float deadzone2[CONTROLLER_OUTPUTS]{};
+    float threshold[CONTROLLER_OUTPUTS]{};
+    /* unit vector, where a button source pushes a stick and which way an axis source has to move
+     * to press a button. 0 for any way */
+    float direction_x[CONTROLLER_OUTPUTS]{};
+    float direction_y[CONTROLLER_OUTPUTS]{};
+    /* sticks and D-pad, [-HID_JOYSTICK_MAX, HID_JOYSTICK_MAX], positive y is down */
+    int32_t x[CONTROLLER_OUTPUTS]{};
+    int32_t y[CONTROLLER_OUTPUTS]{};
+    /* buttons, the scan code and `GamepadButton` they press, -1 for none */
+    int32_t key[CONTROLLER_OUTPUTS]{};
+    int32_t pad_button[CONTROLLER_OUTPUTS]{};
+    bool pressed[CONTROLLER_OUTPUTS]{};
+};
+
+class Config;
+struct ConfigMacro;
 class StickInputHandler;
+class VirtualGamepad;
 
 class NpadController {
 public:
     NpadController();
     ~NpadController();
 
+    /* bakes the response curve and caches the analog properties and output mapping, has to be
+     * called again after they change */
+    void Configure(const Config& config);
+    /* the mouse source, every output mapped to it follows */
     void SetStick(float raw_x, float raw_y);
+    /* every output driven by a source has all of its keys in `config` */
+    bool HasOutputKeys(const Config& config);
     void SetButton(uint32_t button, int value);
+    void SetGamepadButton(uint32_t button, int value);
+    /* presses and releases after `duration_ms` through the `KeyScheduler`, without blocking */
+    void TapButton(uint32_t button, float duration_ms);
+    void TapGamepadButton(uint32_t button, float duration_ms);
+    /* a mouse button as a source, false if no output uses it so it goes to its own binding */
+    bool SetSourceButton(uint32_t mouse_button, bool pressed);
+    /* a wheel notch holds its source for `duration_ms`, returns like `SetSourceButton` */
+    bool TapSourceButton(uint32_t mouse_button, float duration_ms);
+    /* plays the steps through the `KeyScheduler`, a single round unless `repeat` is set and the
+     * macro has a repeat period */
+    void PlayMacro(const ConfigMacro& macro, bool repeat);
+    void StopMacro(const ConfigMacro& macro);
     void SetPersistentMode(bool value);
+    /* holds the stick keys for the part of every `period_ms` matching the stick magnitude */
+    void SetPulseWidthMode(bool value, float period_ms);
+    /* returns false if the platform couldn't provide a virtual gamepad */
+    bool SetVirtualGamepadMode(bool value);
+    bool IsVirtualGamepadMode() const {
+        return gamepad_ != nullptr;
+    }
     void ClearState();
 
 private:
-    void SanatizeAxes(float raw_x, float raw_y, bool clamp_value);
+    void SanatizeAxes(float raw_x, float raw_y);
+    void UpdateOutputs();
+    void SendButton(size_t output, bool pressed);
+    /* lets go of the pressed buttons with the keys they were pressed with */
+    void ReleaseButtons();
+    void ResetGamepad();
 
     StickInputHandler* stick_handler_;
+    VirtualGamepad* gamepad_ = nullptr;
+
+    ResponseCurve curve_;
+    float x_offset_{};
+    float y_offset_{};
+    /* offsets are scaled back into the range by the positive and negative side divisors */
+    float x_scale_[2]{1.f, 1.f};
+    float y_scale_[2]{1.f, 1.f};
 
     float last_raw_x_{};
     float last_raw_y_{};
@@ -34,7 +123,12 @@ private:
     float last_x_{};
     float last_y_{};
 
-    Axes axes_{};
+    ControllerOutputs outputs_{};
+    bool source_pressed_[CONTROLLER_SOURCES]{};
+    /* bit per `ControllerSource` some output follows */
+    uint32_t used_sources_ = 0;
+    /* the scheduler may still send them */
+    std::atomic<bool> has_taps_ = false;
 
     mutable std::mutex mutex;
 };
\ No newline at end of file
@@ -0,0 +1,127 @@
+#include "response_curve.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+#include "Config.h"
+#include "Utils.h"
+
+ResponseCurve::ResponseCurve() {
+    Bake(Config());
+}
+
+void ResponseCurve::Bake(const Config& config) {
+    deadzone_ = config.DEADZONE;
+    range_ = config.RANGE;
+    exponent_ = std::max(config.CURVE_EXPONENT, 0.1f);
+
+    const std::string type = Utils::to_lower(config.CURVE);
+    if (type == "power") {
+        type_ = ResponseCurveType::Power;
+    }
+    else if (type == "scurve") {
+        type_ = ResponseCurveType::SCurve;
+    }
+    else if (type == "custom" && ParsePoints(config.CURVE_POINTS)) {
+        type_ = ResponseCurveType::Custom;
+    }
+    else {
+        if (type != "linear" && type != "custom") {
+            fprintf(stderr, "Unknown response curve \"%s\", expected linear, power, scurve or "
+                            "custom.\n",
+                    config.CURVE.c_str());
+        }
+        type_ = ResponseCurveType::Linear;
+    }
+
+    for (size_t i = 0; i <= LUT_SIZE; i++) {
+        const float magnitude2 = static_cast<float>(i) / static_cast<float>(LUT_SIZE);
+        lut_[i] = ComputeScale(std::sqrt(magnitude2));
+    }
+}
+
+float ResponseCurve::GetScale(float magnitude2) const {
+    const float position = magnitude2 * static_cast<float>(LUT_SIZE);
+    /* the scale at 0 is only a limit, interpolating towards it would squash the smallest moves */
+    if (magnitude2 >= 1.f || position < 1.f) {
+        return ComputeScale(std::sqrt(magnitude2));
+    }
+
+    const size_t index = static_cast<size_t>(position);
+    const float fraction = position - static_cast<float>(index);
+    return lut_[index] + (lut_[index + 1] - lut_[index]) * fraction;
+}
+
+float ResponseCurve::Evaluate(float u) const {
+    /* past full tilt the curves keep growing like the linear one, the clamp takes care of it */
+    if (u > 1.f) {
+        return Evaluate(1.f) * u;
+    }
+
+    switch (type_) {
+    case ResponseCurveType::Linear:
+        return u;
+    case ResponseCurveType::Power:
+        return std::pow(u, exponent_);
+    case ResponseCurveType::SCurve: {
+        const float rising = std::pow(u, exponent_);
+        const float falling = std::pow(1.f - u, exponent_);
+        return rising / (rising + falling);
+    }
+    case ResponseCurveType::Custom:
+        for (size_t i = 1; i < points_count_; i++) {
+            const Point& from = points_[i - 1];
+            const Point& to = points_[i];
+            if (u <= to.input) {
+                const float width = to.input - from.input;
+                const float t = width > 0.f ? (u - from.input) / width : 1.f;
+                return from.output + (to.output - from.output) * t;
+            }
+        }
+        return points_[points_count_ - 1].output;
+    }
+    return u;
+}
+
+float ResponseCurve::ComputeScale(float magnitude) const {
+    if (magnitude <= deadzone_ || magnitude == 0.f || deadzone_ >= 1.0f) {
+        return 0.f;
+    }
+
+    const float u = (magnitude - deadzone_) / (1.0f - deadzone_);
+    const float output = Evaluate(u) / range_;
+    return std::min(output, 1.f) / magnitude;
+}
+
+/* "0:0, 0.5:0.2, 1:1", input and output pairs between 0 and 1 */
+bool ResponseCurve::ParsePoints(const std::string& points) {
+    /* the curve always starts at 0:0 */
+    points_[0] = {0.f, 0.f};
+    points_count_ = 1;
+
+    for (const auto& point : Utils::split_str(points, ",")) {
+        float input = 0.f, output = 0.f;
+        if (sscanf(point.c_str(), " %f : %f", &input, &output) != 2 || input < 0.f || input > 1.f) {
+            fprintf(stderr, "Ignoring invalid curve point \"%s\".\n", point.c_str());
+            continue;
+        }
+        if (points_count_ == MAX_POINTS) {
+            fprintf(stderr, "Only %zu curve points are supported.\n", MAX_POINTS);
+            break;
+        }
+        if (input == 0.f) {
+            continue;
+        }
+        points_[points_count_++] = {input, std::clamp(output, 0.f, 1.f)};
+    }
+
+    if (points_count_ < 2) {
+        fprintf(stderr, "The custom curve needs at least one point past 0, using linear.\n");
+        return false;
+    }
+
+    std::sort(&points_[1], &points_[points_count_],
+              [](const Point& a, const Point& b) { return a.input < b.input; });
+    return true;
+}
\ No newline at end of file
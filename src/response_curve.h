@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+class Config;
+
+enum class ResponseCurveType : uint8_t {
+    Linear,
+    /* `u^exponent` */
+    Power,
+    /* `u^exponent / (u^exponent + (1 - u)^exponent)`, soft around the center and full tilt */
+    SCurve,
+    /* piecewise linear through the `AnalogProperties:CurvePoints` */
+    Custom,
+};
+
+/* Maps the stick magnitude through the deadzone, curve and range of the config. Baked into a table
+ * indexed by the squared magnitude, so applying it costs a lookup and an interpolation, a sqrt is
+ * only needed in the first bucket and past full tilt. */
+class ResponseCurve {
+public:
+    static constexpr size_t LUT_SIZE = 1024;
+    static constexpr size_t MAX_POINTS = 16;
+
+    ResponseCurve();
+
+    void Bake(const Config& config);
+
+    /* factor for a stick vector with `magnitude2 = x * x + y * y`, the scaled vector stays inside
+     * the unit circle */
+    float GetScale(float magnitude2) const;
+
+private:
+    struct Point {
+        float input;
+        float output;
+    };
+
+    /* `u` is the magnitude past the deadzone, 0 at the deadzone and 1 at a magnitude of 1 */
+    float Evaluate(float u) const;
+    float ComputeScale(float magnitude) const;
+    bool ParsePoints(const std::string& points);
+
+    ResponseCurveType type_ = ResponseCurveType::Linear;
+    float exponent_ = 2.f;
+    float deadzone_ = 0.15f;
+    float range_ = 0.95f;
+    Point points_[MAX_POINTS]{};
+    size_t points_count_ = 0;
+
+    /* the last entry is the scale at a magnitude of 1 */
+    float lut_[LUT_SIZE + 1]{};
+};
\ No newline at end of file
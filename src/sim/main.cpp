@@ -0,0 +1,155 @@
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "Config.h"
+#include "simulation.h"
+
+/* the same 1600 counts to the right in 200ms, split into samples `period_ms` apart */
+static std::vector<SimInput> MakeSteadyMove(uint64_t period_ms) {
+    std::vector<SimInput> script;
+    for (uint64_t t = 0; t < 200; t += period_ms) {
+        SimInput input{};
+        input.time_ns = t * 1'000'000;
+        input.type = SimInput::Type::Move;
+        input.dx = static_cast<int>(8 * period_ms);
+        script.push_back(input);
+    }
+    return script;
+}
+
+/* built in scripts, all of them start panning from rest */
+static std::vector<SimInput> MakeScenario(const std::string& name) {
+    std::vector<SimInput> script;
+    auto move = [&script](uint64_t time_ms, int dx, int dy) {
+        SimInput input{};
+        input.time_ns = time_ms * 1'000'000;
+        input.type = SimInput::Type::Move;
+        input.dx = dx;
+        input.dy = dy;
+        script.push_back(input);
+    };
+
+    if (name == "flick") {
+        for (uint64_t t = 0; t < 50; t++)
+            move(t, 20, 0);
+    }
+    else if (name == "slow") {
+        for (uint64_t t = 0; t < 1000; t += 4)
+            move(t, 1, 0);
+    }
+    else if (name == "circle") {
+        /* 8 directions, 100ms each */
+        static constexpr int directions[8][2] = {{12, 0},  {8, 8},   {0, 12},  {-8, 8},
+                                                 {-12, 0}, {-8, -8}, {0, -12}, {8, -8}};
+        for (uint64_t t = 0; t < 800; t += 2)
+            move(t, directions[t / 100][0], directions[t / 100][1]);
+    }
+    return script;
+}
+
+static void PrintUsage(const char* program) {
+    fprintf(stderr,
+            "Usage: %s [--scenario flick|slow|circle|rates] [--script file] [--replay trace_file]\n"
+            "          [--realtime] [--sensitivity value] [--filter stages]\n"
+            "          [--dpi value]\n",
+            program);
+}
+
+int main(int argc, char** argv) {
+    std::string scenario = "flick";
+    std::string script_file;
+    std::string trace_file;
+    bool realtime = false;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--scenario") == 0 && i + 1 < argc) {
+            scenario = argv[++i];
+        }
+        else if (strcmp(argv[i], "--script") == 0 && i + 1 < argc) {
+            script_file = argv[++i];
+        }
+        else if (strcmp(argv[i], "--replay") == 0 && i + 1 < argc) {
+            trace_file = argv[++i];
+        }
+        else if (strcmp(argv[i], "--realtime") == 0) {
+            realtime = true;
+        }
+        else if (strcmp(argv[i], "--filter") == 0 && i + 1 < argc) {
+            Config::Current()->MOUSE_FILTERS = argv[++i];
+        }
+        else if (strcmp(argv[i], "--dpi") == 0 && i + 1 < argc) {
+            Config::Current()->MOUSE_DPI = static_cast<float>(atof(argv[++i]));
+        }
+        else if (strcmp(argv[i], "--sensitivity") == 0 && i + 1 < argc) {
+            Config::Current()->SENSITIVITY = static_cast<float>(atof(argv[++i]));
+        }
+        else {
+            PrintUsage(argv[0]);
+            return 1;
+        }
+    }
+
+    /* the stick follows the distance over time, a 500 Hz and a 1000 Hz mouse have to press the
+     * same keys for as long */
+    if (scenario == "rates" && trace_file.empty() && script_file.empty()) {
+        Simulation simulation{};
+        const SimulationResult slow = simulation.Run(MakeSteadyMove(2));
+        const SimulationResult fast = simulation.Run(MakeSteadyMove(1));
+        const bool same = slow.key_downs == fast.key_downs && slow.key_ups == fast.key_ups &&
+                          memcmp(slow.held_ns, fast.held_ns, sizeof(slow.held_ns)) == 0;
+        fprintf(stdout, "scenario: rates\n");
+        fprintf(stdout, "500 Hz: %zu key downs, right held: %.1fms\n", slow.key_downs,
+                slow.held_ns[1] / 1e6);
+        fprintf(stdout, "1000 Hz: %zu key downs, right held: %.1fms\n", fast.key_downs,
+                fast.held_ns[1] / 1e6);
+        fprintf(stdout, "same output: %s\n", same ? "yes" : "no");
+        return same ? 0 : 1;
+    }
+
+    std::vector<SimInput> script;
+    std::vector<SimKeyTransition> recorded_keys;
+    if (!trace_file.empty()) {
+        if (!Simulation::LoadTrace(trace_file, &script, &recorded_keys))
+            return 1;
+        scenario = trace_file;
+    }
+    else if (!script_file.empty()) {
+        if (!Simulation::LoadScript(script_file, &script))
+            return 1;
+        scenario = script_file;
+    }
+    else {
+        script = MakeScenario(scenario);
+    }
+    if (script.empty()) {
+        fprintf(stderr, "Nothing to simulate for: %s\n", scenario.c_str());
+        return 1;
+    }
+
+    Simulation simulation{};
+    const size_t inputs = script.size();
+    const SimulationResult result = simulation.Run(std::move(script), 200'000'000, realtime);
+
+    static constexpr const char* stick_key_names[4] = {"left", "right", "up", "down"};
+    fprintf(stdout, "scenario: %s\n", scenario.c_str());
+    fprintf(stdout, "simulated: %.1fms in %.1fms (%zu inputs, %.0f inputs/s)\n",
+            result.duration_ns / 1e6, result.wall_ns / 1e6, inputs,
+            result.wall_ns ? inputs / (result.wall_ns / 1e9) : 0.0);
+    fprintf(stdout, "key downs: %zu, key ups: %zu\n", result.key_downs, result.key_ups);
+    if (!trace_file.empty()) {
+        size_t recorded_downs = 0;
+        for (const auto& transition : recorded_keys) {
+            recorded_downs += transition.is_down;
+        }
+        fprintf(stdout, "recorded key downs: %zu, key ups: %zu\n", recorded_downs,
+                recorded_keys.size() - recorded_downs);
+    }
+    fprintf(stdout, "first stick key after: %.1fms\n", result.first_key_down_ns / 1e6);
+    for (int i = 0; i < 4; i++) {
+        fprintf(stdout, "%-5s held: %.1fms\n", stick_key_names[i], result.held_ns[i] / 1e6);
+    }
+    return 0;
+}
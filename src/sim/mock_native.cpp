@@ -0,0 +1,129 @@
+#include "mock_native.h"
+
+#include <algorithm>
+
+std::shared_ptr<Native> Native::GetInstance() {
+    static std::shared_ptr<Native> singleton_(MockNative::GetInstance());
+    return singleton_;
+}
+
+MockNative* MockNative::GetInstance() {
+    if (!instance_) {
+        instance_ = new MockNative();
+    }
+    return instance_;
+}
+
+MockNative* MockNative::instance_ = nullptr;
+
+void MockNative::SetScript(std::vector<SimInput> script) {
+    std::stable_sort(script.begin(), script.end(), [](const SimInput& a, const SimInput& b) {
+        return a.time_ns < b.time_ns;
+    });
+    script_ = std::move(script);
+    script_pos_ = 0;
+}
+
+bool MockNative::IsScriptDone() const {
+    return script_pos_ >= script_.size();
+}
+
+void MockNative::SetTime(uint64_t time_ns) {
+    time_ns_ = time_ns;
+}
+
+uint64_t MockNative::GetTime() const {
+    return time_ns_;
+}
+
+std::vector<SimKeyTransition> MockNative::GetKeyTransitions() const {
+    std::scoped_lock<std::mutex> lock{records_mutex_};
+    return key_transitions_;
+}
+
+std::vector<SimCursorWarp> MockNative::GetCursorWarps() const {
+    std::scoped_lock<std::mutex> lock{records_mutex_};
+    return cursor_warps_;
+}
+
+void MockNative::ClearRecords() {
+    std::scoped_lock<std::mutex> lock{records_mutex_};
+    key_transitions_.clear();
+    cursor_warps_.clear();
+}
+
+void MockNative::RegisterHotKey(uint32_t key, uint32_t modifier) {
+    (void)key;
+    (void)modifier;
+}
+
+void MockNative::UnregisterHotKey(uint32_t key, uint32_t modifier) {
+    (void)key;
+    (void)modifier;
+}
+
+void MockNative::SendKeysDown(uint32_t* keys, size_t count) {
+    std::scoped_lock<std::mutex> lock{records_mutex_};
+    for (size_t i = 0; i < count; i++) {
+        key_transitions_.push_back({time_ns_, keys[i], true});
+    }
+}
+
+void MockNative::SendKeysUp(uint32_t* keys, size_t count) {
+    std::scoped_lock<std::mutex> lock{records_mutex_};
+    for (size_t i = 0; i < count; i++) {
+        key_transitions_.push_back({time_ns_, keys[i], false});
+    }
+}
+
+void MockNative::SetMousePos(int x, int y) {
+    cursor_x_ = x;
+    cursor_y_ = y;
+    std::scoped_lock<std::mutex> lock{records_mutex_};
+    cursor_warps_.push_back({time_ns_, x, y});
+}
+
+void MockNative::GetMousePos(int* x_ret, int* y_ret) {
+    *x_ret = cursor_x_;
+    *y_ret = cursor_y_;
+}
+
+NativeWindow MockNative::GetFocusedWindow() {
+    return 0;
+}
+
+bool MockNative::SetFocusOnWindow(const NativeWindow window) {
+    (void)window;
+    return true;
+}
+
+bool MockNative::IsMainWindowActive(const std::string& window_name) {
+    (void)window_name;
+    return true;
+}
+
+bool MockNative::SetFocusOnWindow(const std::string& window_name) {
+    (void)window_name;
+    return true;
+}
+
+void MockNative::CursorHide(bool hide) {
+    (void)hide;
+}
+
+void MockNative::Update() {
+    while (script_pos_ < script_.size() && script_[script_pos_].time_ns <= time_ns_) {
+        const SimInput& input = script_[script_pos_++];
+        if (input.type == SimInput::Type::Move) {
+            cursor_x_ += input.dx;
+            cursor_y_ += input.dy;
+        }
+        else if (input.type == SimInput::Type::RawMove) {
+            EventBus::Instance().publish(MouseMotionEvent(input.raw_dx, input.raw_dy));
+        }
+        else {
+            EventBus::Instance().publish(
+                MouseButtonEvent(input.button, input.is_pressed, cursor_x_, cursor_y_));
+        }
+    }
+}
@@ -0,0 +1,90 @@
+#pragma once
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "native.h"
+
+/* one scripted input, `time_ns` is relative to the start of the simulation */
+struct SimInput {
+    enum class Type {
+        Move,
+        /* published as a `MouseMotionEvent`, like the raw motion of the platform backends */
+        RawMove,
+        Button,
+    };
+
+    uint64_t time_ns;
+    Type type;
+    /* `Move`: relative cursor movement */
+    int dx;
+    int dy;
+    /* `RawMove`: device movement */
+    float raw_dx;
+    float raw_dy;
+    /* `Button`: one of the `MOUSE_*BUTTON`s */
+    uint32_t button;
+    bool is_pressed;
+};
+
+struct SimKeyTransition {
+    uint64_t time_ns;
+    uint32_t key;
+    bool is_down;
+};
+
+struct SimCursorWarp {
+    uint64_t time_ns;
+    int x;
+    int y;
+};
+
+/* `Native` without any OS behind it, plays a script of inputs against a virtual clock and records
+ * everything the pipeline sends back */
+class MockNative : public Native {
+public:
+    static MockNative* GetInstance();
+
+    void SetScript(std::vector<SimInput> script);
+    bool IsScriptDone() const;
+    void SetTime(uint64_t time_ns);
+    uint64_t GetTime() const;
+
+    std::vector<SimKeyTransition> GetKeyTransitions() const;
+    std::vector<SimCursorWarp> GetCursorWarps() const;
+    void ClearRecords();
+
+    void RegisterHotKey(uint32_t key, uint32_t modifier) override;
+    void UnregisterHotKey(uint32_t key, uint32_t modifier) override;
+    void SendKeysDown(uint32_t* keys, size_t count) override;
+    void SendKeysUp(uint32_t* keys, size_t count) override;
+    void SetMousePos(int x, int y) override;
+    void GetMousePos(int* x_ret, int* y_ret) override;
+
+    NativeWindow GetFocusedWindow() override;
+    bool SetFocusOnWindow(const NativeWindow window) override;
+    bool IsMainWindowActive(const std::string& window_name) override;
+    bool SetFocusOnWindow(const std::string& window_name) override;
+
+    void CursorHide(bool hide) override;
+
+    /* delivers the scripted inputs which are due at the current time */
+    void Update() override;
+
+private:
+    MockNative() = default;
+
+    static MockNative* instance_;
+
+    std::vector<SimInput> script_;
+    size_t script_pos_ = 0;
+    uint64_t time_ns_ = 0;
+    int cursor_x_ = 0;
+    int cursor_y_ = 0;
+
+    /* keys might also be sent from the `KeyScheduler` thread */
+    mutable std::mutex records_mutex_;
+    std::vector<SimKeyTransition> key_transitions_;
+    std::vector<SimCursorWarp> cursor_warps_;
+};
@@ -0,0 +1,254 @@
+#include "simulation.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+
+#include "Config.h"
+#include "Utils.h"
+#include "input_trace.h"
+#include "keyboard_manager.h"
+
+Simulation* Simulation::instance_ = nullptr;
+
+Simulation::Simulation()
+    : native_(MockNative::GetInstance()), mouse_(&controller_, false) {
+    static bool subscribed = false;
+
+    KeyboardManager::UseManualUpdate();
+    keyboard_ = KeyboardManager::GetInstance();
+
+    if (!subscribed) {
+        EventBus::Instance().subscribe(&Simulation::OnMouseButton);
+        EventBus::Instance().subscribe(&Simulation::OnMouseMotion);
+        subscribed = true;
+    }
+    instance_ = this;
+}
+
+Simulation::~Simulation() {
+    instance_ = nullptr;
+}
+
+SimulationResult Simulation::Run(std::vector<SimInput> script, uint64_t tail_ns, bool realtime) {
+    SimulationResult result{};
+
+    uint64_t first_move_ns = UINT64_MAX;
+    uint64_t end_ns = 0;
+    for (const auto& input : script) {
+        if (input.type != SimInput::Type::Button && input.time_ns < first_move_ns) {
+            first_move_ns = input.time_ns;
+        }
+        if (input.time_ns > end_ns) {
+            end_ns = input.time_ns;
+        }
+    }
+    end_ns += tail_ns;
+
+    Config::Publish();
+    mouse_.Configure(*Config::Current());
+    controller_.Configure(*Config::Current());
+    native_->SetTime(0);
+    native_->SetMousePos(center_x_, center_y_);
+    native_->SetScript(std::move(script));
+    native_->ClearRecords();
+
+    mouse_.SetPanning(true);
+    const auto started_at = std::chrono::steady_clock::now();
+    const uint64_t started_ns = Utils::now_ns();
+    uint64_t time_ns = 0;
+    for (; time_ns <= end_ns; time_ns += STEP_NS) {
+        if (realtime) {
+            std::this_thread::sleep_until(started_at + std::chrono::nanoseconds(time_ns));
+        }
+        Step(time_ns);
+    }
+    mouse_.SetPanning(false);
+    controller_.ClearState();
+    keyboard_->Update();
+
+    result.duration_ns = time_ns;
+    result.wall_ns = Utils::now_ns() - started_ns;
+
+    const auto transitions = native_->GetKeyTransitions();
+    uint64_t pressed_at[4]{};
+    bool is_down[4]{};
+    for (const auto& transition : transitions) {
+        transition.is_down ? result.key_downs++ : result.key_ups++;
+
+        for (int i = 0; i < 4; i++) {
+            if (transition.key != static_cast<uint32_t>(Config::Current()->RIGHT_STICK_KEYS[i]))
+                continue;
+
+            if (transition.is_down && !is_down[i]) {
+                is_down[i] = true;
+                pressed_at[i] = transition.time_ns;
+                if (result.first_key_down_ns == 0 && transition.time_ns >= first_move_ns) {
+                    /* a key sent in the same frame still took that frame */
+                    result.first_key_down_ns = transition.time_ns - first_move_ns + STEP_NS;
+                }
+            }
+            else if (!transition.is_down && is_down[i]) {
+                is_down[i] = false;
+                result.held_ns[i] += transition.time_ns - pressed_at[i];
+            }
+        }
+    }
+
+    return result;
+}
+
+void Simulation::Step(uint64_t time_ns) {
+    native_->SetTime(time_ns);
+    native_->Update();
+
+    /* same as `Application::DetectMouseMove` while panning */
+    int x = 0, y = 0;
+    native_->GetMousePos(&x, &y);
+    if (x != center_x_ || y != center_y_) {
+        mouse_.MouseMoved(x, y, center_x_, center_y_, MOUSE_EPOCH_NS + time_ns);
+        native_->SetMousePos(center_x_, center_y_);
+    }
+
+    if (time_ns % MOUSE_TICK_NS == 0) {
+        mouse_.Update();
+    }
+    keyboard_->Update();
+}
+
+void Simulation::OnMouseMotion(MouseMotionEvent& evt) {
+    if (instance_) {
+        /* `published_ns` is on the real clock */
+        instance_->mouse_.MouseMoved(evt.dx, evt.dy,
+                                     MOUSE_EPOCH_NS + instance_->native_->GetTime());
+    }
+}
+
+void Simulation::OnMouseButton(MouseButtonEvent& evt) {
+    if (!instance_ || !Config::Current()->BIND_MOUSE_BUTTON) {
+        return;
+    }
+
+    int key = -1;
+    switch (evt.key) {
+    case MOUSE_LBUTTON:
+        key = Config::Current()->LEFT_MOUSE_KEY;
+        break;
+    case MOUSE_RBUTTON:
+        key = Config::Current()->RIGHT_MOUSE_KEY;
+        break;
+    case MOUSE_MBUTTON:
+        key = Config::Current()->MIDDLE_MOUSE_KEY;
+        break;
+    }
+    if (key >= 0) {
+        instance_->controller_.SetButton(static_cast<uint32_t>(key), evt.is_pressed);
+    }
+}
+
+bool Simulation::LoadScript(const std::string& file, std::vector<SimInput>* script) {
+    FILE* script_file = fopen(file.c_str(), "r");
+    if (!script_file) {
+        fprintf(stderr, "Couldn't open script: %s\n", file.c_str());
+        return false;
+    }
+
+    bool result = true;
+    char line[256];
+    int line_number = 0;
+    while (fgets(line, sizeof(line), script_file)) {
+        line_number++;
+        if (char* comment = strchr(line, '#')) {
+            *comment = '\0';
+        }
+
+        double time_ms = 0;
+        char type[16]{};
+        char first[16]{};
+        char second[16]{};
+        const int fields = sscanf(line, "%lf %15s %15s %15s", &time_ms, type, first, second);
+        if (fields <= 0) {
+            continue;
+        }
+
+        SimInput input{};
+        input.time_ns = static_cast<uint64_t>(time_ms * 1e6);
+        bool valid = fields == 4;
+        if (valid && strcmp(type, "move") == 0) {
+            input.type = SimInput::Type::Move;
+            input.dx = atoi(first);
+            input.dy = atoi(second);
+        }
+        else if (valid && strcmp(type, "button") == 0) {
+            input.type = SimInput::Type::Button;
+            if (strcmp(first, "left") == 0)
+                input.button = MOUSE_LBUTTON;
+            else if (strcmp(first, "right") == 0)
+                input.button = MOUSE_RBUTTON;
+            else if (strcmp(first, "middle") == 0)
+                input.button = MOUSE_MBUTTON;
+            input.is_pressed = strcmp(second, "down") == 0;
+            valid = input.button != 0 && (input.is_pressed || strcmp(second, "up") == 0);
+        }
+        else {
+            valid = false;
+        }
+
+        if (!valid) {
+            fprintf(stderr, "%s:%d: invalid input\n", file.c_str(), line_number);
+            result = false;
+            break;
+        }
+        script->push_back(input);
+    }
+
+    fclose(script_file);
+    return result;
+}
+
+
+bool Simulation::LoadTrace(const std::string& file, std::vector<SimInput>* script,
+                           std::vector<SimKeyTransition>* recorded_keys) {
+    InputTraceReader reader;
+    if (!reader.Open(file)) {
+        return false;
+    }
+
+    /* appends from different threads may be slightly out of order, start at the earliest */
+    const InputTraceRecord* records = reader.GetRecords();
+    uint64_t first_ns = UINT64_MAX;
+    for (size_t i = 0; i < reader.GetCount(); i++) {
+        first_ns = std::min(first_ns, records[i].time_ns);
+    }
+
+    for (size_t i = 0; i < reader.GetCount(); i++) {
+        const InputTraceRecord& record = records[i];
+        SimInput input{};
+        input.time_ns = record.time_ns - first_ns;
+        switch (record.type) {
+        case InputTraceType::MouseDelta:
+            input.type = SimInput::Type::RawMove;
+            input.raw_dx = record.dx;
+            input.raw_dy = record.dy;
+            script->push_back(input);
+            break;
+        case InputTraceType::MouseButton:
+            input.type = SimInput::Type::Button;
+            input.button = record.code;
+            input.is_pressed = record.is_pressed != 0;
+            script->push_back(input);
+            break;
+        case InputTraceType::KeyDown:
+        case InputTraceType::KeyUp:
+            if (recorded_keys) {
+                recorded_keys->push_back(
+                    {input.time_ns, record.code, record.type == InputTraceType::KeyDown});
+            }
+            break;
+        }
+    }
+    return true;
+}
@@ -0,0 +1,69 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "mock_native.h"
+#include "mouse.h"
+#include "npad_controller.h"
+
+class KeyboardManager;
+
+struct SimulationResult {
+    uint64_t duration_ns;
+    size_t key_downs;
+    size_t key_ups;
+    /* from the first scripted movement to the first stick key press, 0 if none was pressed */
+    uint64_t first_key_down_ns;
+    /* how long each of the `RIGHT_STICK_KEYS` was held down */
+    uint64_t held_ns[4];
+    /* real time the run took */
+    uint64_t wall_ns;
+};
+
+/* Runs `Mouse`, `NpadController` and `KeyboardManager` on the calling thread against the
+ * `MockNative` virtual clock, the same script always produces the same key transitions. */
+class Simulation {
+public:
+    /* `KeyboardManager` frame and `Mouse` tick periods of the threaded pipeline */
+    static constexpr uint64_t STEP_NS = 1'000'000;
+    static constexpr uint64_t MOUSE_TICK_NS = 10'000'000;
+    /* added to the virtual clock for `Mouse`, which takes a time of 0 for now */
+    static constexpr uint64_t MOUSE_EPOCH_NS = 1'000'000'000;
+
+    Simulation();
+    ~Simulation();
+
+    Simulation(const Simulation&) = delete;
+    Simulation& operator=(const Simulation&) = delete;
+
+    /* plays the whole script while panning, then keeps going for `tail_ns`. Runs as fast as
+     * possible unless `realtime`, then every step waits for its time to come. */
+    SimulationResult Run(std::vector<SimInput> script, uint64_t tail_ns = 200'000'000,
+                         bool realtime = false);
+
+    /* lines of `<time ms> move <dx> <dy>` or `<time ms> button <left|right|middle> <down|up>`,
+     * `#` starts a comment */
+    static bool LoadScript(const std::string& file, std::vector<SimInput>* script);
+    /* pointer deltas and buttons of an `InputTraceWriter` recording, the keys it recorded are
+     * appended to `recorded_keys` if given */
+    static bool LoadTrace(const std::string& file, std::vector<SimInput>* script,
+                          std::vector<SimKeyTransition>* recorded_keys = nullptr);
+
+private:
+    void Step(uint64_t time_ns);
+
+    static void OnMouseButton(MouseButtonEvent& evt);
+    static void OnMouseMotion(MouseMotionEvent& evt);
+
+    static Simulation* instance_;
+
+    MockNative* native_;
+    NpadController controller_;
+    Mouse mouse_;
+    std::shared_ptr<KeyboardManager> keyboard_;
+
+    int center_x_ = 960;
+    int center_y_ = 540;
+};
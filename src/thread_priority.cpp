@@ -0,0 +1,254 @@
+#include "thread_priority.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+#include "Config.h"
+#include "Utils.h"
+
+#ifdef _WIN32
+#include <Windows.h>
+#else
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#endif
+
+std::mutex ThreadPriority::mutex_;
+std::vector<ThreadPriority::Thread> ThreadPriority::threads_;
+ThreadPriority::Settings ThreadPriority::settings_;
+bool ThreadPriority::memory_locked_ = false;
+
+ThreadPriority::Scope::Scope(const char* name) {
+#ifdef _WIN32
+    const uintptr_t handle = reinterpret_cast<uintptr_t>(
+        OpenThread(THREAD_SET_INFORMATION | THREAD_QUERY_INFORMATION, FALSE, GetCurrentThreadId()));
+    if (!handle)
+        return;
+#else
+    /* an integer on Linux and a pointer on macOS */
+    const uintptr_t handle = (uintptr_t)pthread_self();
+#endif
+
+    std::scoped_lock<std::mutex> lock(mutex_);
+    threads_.push_back({name, handle});
+    if (settings_.policy != Policy::Normal || !settings_.cpus.empty()) {
+        ApplyToThread(threads_.back(), settings_);
+    }
+}
+
+ThreadPriority::Scope::~Scope() {
+#ifdef _WIN32
+    const DWORD id = GetCurrentThreadId();
+    std::scoped_lock<std::mutex> lock(mutex_);
+    auto it = std::ranges::find_if(threads_, [id](const Thread& thread) {
+        return GetThreadId(reinterpret_cast<HANDLE>(thread.handle)) == id;
+    });
+    if (it != threads_.end()) {
+        CloseHandle(reinterpret_cast<HANDLE>(it->handle));
+        threads_.erase(it);
+    }
+#else
+    const pthread_t self = pthread_self();
+    std::scoped_lock<std::mutex> lock(mutex_);
+    auto it = std::ranges::find_if(threads_, [self](const Thread& thread) {
+        return pthread_equal((pthread_t)thread.handle, self);
+    });
+    if (it != threads_.end()) {
+        threads_.erase(it);
+    }
+#endif
+}
+
+void ThreadPriority::Apply(const Config& config) {
+    Settings settings = Parse(config);
+
+    std::scoped_lock<std::mutex> lock(mutex_);
+    /* nothing to undo, keeps the startup quiet when the options aren't used */
+    const bool was_default = settings_.policy == Policy::Normal && settings_.cpus.empty();
+    const bool is_default = settings.policy == Policy::Normal && settings.cpus.empty();
+    if (!was_default || !is_default) {
+        for (const auto& thread : threads_) {
+            ApplyToThread(thread, settings);
+        }
+    }
+    if (settings.lock_memory != memory_locked_) {
+        LockMemory(settings.lock_memory);
+    }
+    settings_ = std::move(settings);
+}
+
+ThreadPriority::Settings ThreadPriority::Parse(const Config& config) {
+    Settings settings{};
+
+    const std::string policy = Utils::to_lower(config.THREAD_POLICY);
+    if (policy == "fifo") {
+        settings.policy = Policy::Fifo;
+    }
+    else if (policy == "rr") {
+        settings.policy = Policy::RoundRobin;
+    }
+    else if (policy != "normal" && !policy.empty()) {
+        fprintf(stderr, "Unknown thread policy \"%s\", expected normal, fifo or rr.\n",
+                config.THREAD_POLICY.c_str());
+    }
+    settings.priority = std::clamp(config.THREAD_PRIORITY, 1, 99);
+
+    /* "2,3" or "2-5", or a mix of both */
+    if (!config.THREAD_CPUS.empty()) {
+        for (const auto& part : Utils::split_str(config.THREAD_CPUS, ",")) {
+            unsigned first = 0, last = 0;
+            const int matched = sscanf(part.c_str(), "%u-%u", &first, &last);
+            if (matched < 1 || (matched == 2 && last < first) || first >= 1024) {
+                fprintf(stderr, "Ignoring invalid cpu \"%s\".\n", part.c_str());
+                continue;
+            }
+            if (matched == 1)
+                last = first;
+            for (unsigned cpu = first; cpu <= last && cpu < 1024; cpu++) {
+                settings.cpus.push_back(cpu);
+            }
+        }
+    }
+
+    settings.lock_memory = config.LOCK_MEMORY;
+    return settings;
+}
+
+#ifdef _WIN32
+void ThreadPriority::ApplyToThread(const Thread& thread, const Settings& settings) {
+    HANDLE handle = reinterpret_cast<HANDLE>(thread.handle);
+
+    /* no fifo/rr on Windows, the closest is the time critical priority */
+    const int priority = settings.policy == Policy::Normal ? THREAD_PRIORITY_NORMAL
+                                                           : THREAD_PRIORITY_TIME_CRITICAL;
+    if (SetThreadPriority(handle, priority)) {
+        fprintf(stdout, "%s: %s priority\n", thread.name,
+                priority == THREAD_PRIORITY_NORMAL ? "normal" : "time critical");
+    }
+    else {
+        fprintf(stderr, "%s: couldn't change the priority: %lu\n", thread.name, GetLastError());
+    }
+
+    DWORD_PTR mask = 0;
+    for (const uint32_t cpu : settings.cpus) {
+        if (cpu < sizeof(DWORD_PTR) * 8)
+            mask |= static_cast<DWORD_PTR>(1) << cpu;
+    }
+    if (mask == 0) {
+        DWORD_PTR system_mask = 0;
+        GetProcessAffinityMask(GetCurrentProcess(), &mask, &system_mask);
+    }
+    if (SetThreadAffinityMask(handle, mask)) {
+        fprintf(stdout, "%s: cpu mask 0x%llx\n", thread.name,
+                static_cast<unsigned long long>(mask));
+    }
+    else {
+        fprintf(stderr, "%s: couldn't set the cpu mask: %lu\n", thread.name, GetLastError());
+    }
+}
+
+void ThreadPriority::LockMemory(bool lock) {
+    (void)lock;
+    fprintf(stderr, "Locking the memory is not supported on Windows.\n");
+}
+#else
+#if !defined(__APPLE__) && !defined(__MACH__)
+static cpu_set_t GetProcessCpus() {
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    sched_getaffinity(0, sizeof(cpus), &cpus);
+    return cpus;
+}
+
+/* taken while loading, before any thread could be pinned. a thread's own mask may already be a
+ * pinned one, e.g. the input thread applies a reloaded config when headless */
+static const cpu_set_t process_cpus = GetProcessCpus();
+#endif
+
+void ThreadPriority::ApplyToThread(const Thread& thread, const Settings& settings) {
+    const pthread_t handle = (pthread_t)thread.handle;
+
+    int policy = SCHED_OTHER;
+    sched_param param{};
+    if (settings.policy != Policy::Normal) {
+        policy = settings.policy == Policy::Fifo ? SCHED_FIFO : SCHED_RR;
+        param.sched_priority = settings.priority;
+    }
+
+    int error = pthread_setschedparam(handle, policy, &param);
+#ifdef RLIMIT_RTPRIO
+    /* unprivileged users may still get real-time priorities up to RLIMIT_RTPRIO */
+    rlimit rtprio{};
+    if (error == EPERM && policy != SCHED_OTHER && getrlimit(RLIMIT_RTPRIO, &rtprio) == 0 &&
+        rtprio.rlim_cur > 0 && rtprio.rlim_cur < static_cast<rlim_t>(param.sched_priority)) {
+        param.sched_priority = static_cast<int>(rtprio.rlim_cur);
+        error = pthread_setschedparam(handle, policy, &param);
+    }
+#endif
+
+    if (error == 0) {
+        const char* policy_name = policy == SCHED_FIFO ? "SCHED_FIFO"
+                                  : policy == SCHED_RR ? "SCHED_RR"
+                                                       : "SCHED_OTHER";
+        fprintf(stdout, "%s: %s priority %d\n", thread.name, policy_name, param.sched_priority);
+    }
+    else {
+        fprintf(stderr, "%s: couldn't change the scheduler (%s), keeping the current one\n",
+                thread.name, strerror(error));
+    }
+
+#if defined(__APPLE__) || defined(__MACH__)
+    if (!settings.cpus.empty()) {
+        fprintf(stderr, "%s: pinning to cpus is not supported on macOS\n", thread.name);
+    }
+#else
+    cpu_set_t cpus;
+    CPU_ZERO(&cpus);
+    for (const uint32_t cpu : settings.cpus) {
+        if (cpu < CPU_SETSIZE)
+            CPU_SET(cpu, &cpus);
+    }
+    /* undoes an earlier pinning */
+    if (CPU_COUNT(&cpus) == 0) {
+        cpus = process_cpus;
+    }
+
+    error = pthread_setaffinity_np(handle, sizeof(cpus), &cpus);
+    if (error == 0) {
+        fprintf(stdout, "%s: pinned to %d cpus\n", thread.name, CPU_COUNT(&cpus));
+    }
+    else {
+        fprintf(stderr, "%s: couldn't pin to the cpus (%s)\n", thread.name, strerror(error));
+    }
+#endif
+}
+
+void ThreadPriority::LockMemory(bool lock) {
+    if (!lock) {
+        munlockall();
+        memory_locked_ = false;
+        fprintf(stdout, "Unlocked the memory.\n");
+        return;
+    }
+
+    /* with a limited RLIMIT_MEMLOCK future mappings would start failing once it is reached, only
+     * the current pages are locked then */
+    rlimit memlock{};
+    const bool unlimited =
+        getrlimit(RLIMIT_MEMLOCK, &memlock) == 0 && memlock.rlim_cur == RLIM_INFINITY;
+    const int flags = unlimited ? MCL_CURRENT | MCL_FUTURE : MCL_CURRENT;
+    if (mlockall(flags) == 0) {
+        memory_locked_ = true;
+        fprintf(stdout, "Locked the %s memory.\n", unlimited ? "current and future" : "current");
+    }
+    else {
+        fprintf(stderr, "Couldn't lock the memory (%s), raise RLIMIT_MEMLOCK or run with "
+                        "CAP_IPC_LOCK.\n",
+                strerror(errno));
+    }
+}
+#endif
\ No newline at end of file
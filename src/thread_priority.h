@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <vector>
+
+class Config;
+
+/* Real-time scheduling, CPU pinning and memory locking for the input pipeline threads. The threads
+ * register themselves for their lifetime, `Apply` (re)applies the config to every one of them and
+ * logs what the OS actually allowed. */
+class ThreadPriority {
+public:
+    /* registers the calling thread while it lives, gets the last applied settings right away */
+    class Scope {
+    public:
+        explicit Scope(const char* name);
+        ~Scope();
+
+        Scope(const Scope&) = delete;
+        Scope& operator=(const Scope&) = delete;
+    };
+
+    static void Apply(const Config& config);
+
+private:
+    enum class Policy { Normal, Fifo, RoundRobin };
+
+    struct Settings {
+        Policy policy = Policy::Normal;
+        int priority = 0;
+        /* empty keeps the process' affinity */
+        std::vector<uint32_t> cpus;
+        bool lock_memory = false;
+    };
+
+    struct Thread {
+        const char* name;
+        /* pthread_t or the thread's HANDLE on Windows */
+        uintptr_t handle;
+    };
+
+    static Settings Parse(const Config& config);
+    static void ApplyToThread(const Thread& thread, const Settings& settings);
+    static void LockMemory(bool lock);
+
+    static std::mutex mutex_;
+    static std::vector<Thread> threads_;
+    static Settings settings_;
+    static bool memory_locked_;
+};
\ No newline at end of file
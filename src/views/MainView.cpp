@@ -9,12 +9,11 @@
 
 #include "Application.h"
 #include "Config.h"
+#include "mouse.h"
 #include "native.h"
 #include "npad_controller.h"
 #include "Utils.h"
 
-const char* INI_FILE = "RMB.ini";
-
 constexpr int kLeftMouseBtnIndex = 0;
 constexpr int kRightMouseBtnIndex = 1;
 constexpr int kMiddleMouseBtnIndex = 2;
@@ -221,7 +220,10 @@ void MainView::Show() {
 
     ImGui::NewLine();
 
-    ImGui::Checkbox("Hide Mouse on inactivity", &Config::Current()->HIDE_MOUSE);
+    if (ImGui::Checkbox("Hide Mouse on inactivity", &Config::Current()->HIDE_MOUSE)) {
+        Config::Publish();
+        Application::GetInstance()->RefreshEventLoopTimers();
+    }
     if (ImGui::IsItemHovered())
         ImGui::SetTooltip("Hides the normal mouse cursor on inactivity.");
     ImGui::Checkbox("Auto Focus Emulator Window", &Config::Current()->AUTO_FOCUS_EMU_WINDOW);
@@ -234,6 +236,8 @@ void MainView::Show() {
     if (ImGui::Checkbox("Persistant Key Press", &Config::Current()->PERSISTANT_KEY_PRESS)) {
         Application::GetInstance()->GetController()->SetPersistentMode(
             Config::Current()->PERSISTANT_KEY_PRESS);
+        Config::Publish();
+        Application::GetInstance()->RefreshEventLoopTimers();
     }
     if (ImGui::IsItemHovered())
         ImGui::SetTooltip("Continiously presses keys, might be useful\nfor some emulators.");
@@ -250,6 +254,18 @@ void MainView::Show() {
         ImGui::SetTooltip(
             "Camera sensitivity. The higher the faster the camera\nview will be changed.");
 
+    ImGui::Text("Mouse DPI:");
+    if (ImGui::InputFloat("##mouse_dpi", &Config::Current()->MOUSE_DPI, 100.f, 400.f, "%0.0f")) {
+        if (Config::Current()->MOUSE_DPI < 100.f)
+            Config::Current()->MOUSE_DPI = 100.f;
+        else if (Config::Current()->MOUSE_DPI > 32000.f)
+            Config::Current()->MOUSE_DPI = 32000.f;
+        Application::GetInstance()->GetMouse()->Configure(*Config::Current());
+    }
+
+    if (ImGui::IsItemHovered())
+        ImGui::SetTooltip("DPI of your mouse, keeps the camera speed the same\nwhen switching mice.");
+
     ImGui::NewLine();
 
     /* configure input keys */
@@ -429,6 +445,7 @@ void MainView::Show() {
             Config::Current()->DEADZONE = 0.f;
         else if (Config::Current()->DEADZONE > 1.f)
             Config::Current()->DEADZONE = 1.f;
+        Application::GetInstance()->GetController()->Configure(*Config::Current());
     }
     if (ImGui::IsItemHovered())
         ImGui::SetTooltip("Deadzone for X and Y axis.");
@@ -439,27 +456,18 @@ void MainView::Show() {
             Config::Current()->RANGE = 0.25f;
         else if (Config::Current()->RANGE > 1.50f)
             Config::Current()->RANGE = 1.50f;
+        Application::GetInstance()->GetController()->Configure(*Config::Current());
     }
     if (ImGui::IsItemHovered())
         ImGui::SetTooltip("Range for X and Y axis.");
 
-    /*ImGui::Text("Threshold:");
-    if (ImGui::InputFloat("##threshold", &Config::Current()->THRESHOLD, 0.1f, 1.f, "%0.4f"))
-    {
-        if (Config::Current()->DEADZONE < 0.25f)
-            Config::Current()->DEADZONE = 0.25f;
-        else if (Config::Current()->DEADZONE > 1.50f)
-            Config::Current()->DEADZONE = 1.50f;
-    }
-    if (ImGui::IsItemHovered())
-        ImGui::SetTooltip("Threshold for X and Y axis.");*/
-
     ImGui::Text("X Offset:");
     if (ImGui::InputFloat("##x_offset", &Config::Current()->X_OFFSET, 0.05f, 0.2f, "%0.4f")) {
         if (Config::Current()->X_OFFSET < -1.f)
             Config::Current()->X_OFFSET = -1.f;
         else if (Config::Current()->X_OFFSET > 1.f)
             Config::Current()->X_OFFSET = 1.f;
+        Application::GetInstance()->GetController()->Configure(*Config::Current());
     }
     if (ImGui::IsItemHovered())
         ImGui::SetTooltip("Offset for X axis.");
@@ -470,6 +478,7 @@ void MainView::Show() {
             Config::Current()->Y_OFFSET = -1.f;
         else if (Config::Current()->Y_OFFSET > 1.f)
             Config::Current()->Y_OFFSET = 1.f;
+        Application::GetInstance()->GetController()->Configure(*Config::Current());
     }
     if (ImGui::IsItemHovered())
         ImGui::SetTooltip("Offset for Y axis.");
@@ -484,6 +493,11 @@ void MainView::Show() {
         test_type = 0;
 #endif
     ImGui::End();
+
+    /* whatever was edited this frame reaches the input threads as one new snapshot */
+    if (Config::HasUnpublishedChanges()) {
+        Config::Publish();
+    }
 }
 
 void MainView::OnKeyRelease(int key, int scancode, int mods) {
@@ -651,6 +665,14 @@ void MainView::GetMouseButtons() {
 void MainView::SaveConfig() {
     for (int i = 0; i < 4; i++) {
         Config::Current()->RIGHT_STICK_KEYS[i] = r_btn_key_codes_[i];
+        Config::Current()->LEFT_STICK_KEYS[i] = l_stick_key_codes_[i];
+        Config::Current()->DPAD_KEYS[i] = dpad_key_codes_[i];
+    }
+    for (int i = 0; i < 6; i++) {
+        Config::Current()->EXTRA_MOUSE_KEYS[i] = extra_mouse_key_codes_[i];
+    }
+    for (size_t i = 0; i < Config::BUTTON_OUTPUTS; i++) {
+        Config::Current()->BUTTON_KEYS[i] = button_key_codes_[i];
     }
 
     Config::Current()->LEFT_MOUSE_KEY = mouse_btn_key_codes_[0];
@@ -660,17 +682,32 @@ void MainView::SaveConfig() {
     Config::Current()->TOGGLE_MODIFIER = GlfwAndKeys::GetInstance().scancodes_to_glfw[GlfwAndKeys::GetInstance().glfw_toggle_modifiers[toggle_modifier_selected]];
     Config::Current()->TOGGLE_KEY = GlfwAndKeys::GetInstance().scancodes_to_glfw[toggle_key_selected];
 
-    Config::Current()->Save(INI_FILE);
+    Config::Current()->Save(Config::INI_FILE);
+}
+
+void MainView::ReloadConfig() {
+    ReadConfig();
+    GetToggleKeys();
+    GetRightStickButtons();
+    GetMouseButtons();
 }
 
 void MainView::ReadConfig() {
-    auto new_conf = Config::LoadNew(INI_FILE);
+    auto new_conf = Config::LoadNew(Config::INI_FILE);
     if (!new_conf) {
         return;
     }
 
     for (int i = 0; i < 4; i++) {
         r_btn_key_codes_[i] = new_conf->RIGHT_STICK_KEYS[i];
+        l_stick_key_codes_[i] = new_conf->LEFT_STICK_KEYS[i];
+        dpad_key_codes_[i] = new_conf->DPAD_KEYS[i];
+    }
+    for (int i = 0; i < 6; i++) {
+        extra_mouse_key_codes_[i] = new_conf->EXTRA_MOUSE_KEYS[i];
+    }
+    for (size_t i = 0; i < Config::BUTTON_OUTPUTS; i++) {
+        button_key_codes_[i] = new_conf->BUTTON_KEYS[i];
     }
 
     mouse_btn_key_codes_[0] = new_conf->LEFT_MOUSE_KEY;
@@ -13,6 +13,8 @@ public:
     ~MainView();
 
     void Show() override;
+    /* reads `RMB.ini` again and applies it */
+    void ReloadConfig();
     void OnKeyRelease(int key, int scancode, int mods) override;
     void SetSize(uint32_t width, uint32_t height) override {
         (void)width;
@@ -44,6 +46,12 @@ private:
     std::string r_btn_text_[4];
     bool r_btn_changing_[4]{false};
 
+    /* only set in RMB.ini, kept as key codes for saving them back */
+    int l_stick_key_codes_[4]{-1, -1, -1, -1};
+    int dpad_key_codes_[4]{-1, -1, -1, -1};
+    int extra_mouse_key_codes_[6]{-1, -1, -1, -1, -1, -1};
+    int button_key_codes_[8]{-1, -1, -1, -1, -1, -1, -1, -1};
+
     int mouse_btn_key_codes_[3]{};
     std::string mouse_btn_text_[3];
     bool mouse_btn_changing_[3]{false};
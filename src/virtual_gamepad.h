@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstdint>
+
+constexpr int32_t HID_JOYSTICK_MAX = 0x7fff;
+
+enum class GamepadButton : uint32_t {
+    A,
+    B,
+    X,
+    Y,
+    L,
+    R,
+    ZL,
+    ZR,
+    Minus,
+    Plus,
+    LStick,
+    RStick,
+    Count,
+};
+
+enum class GamepadStick : uint32_t {
+    Left,
+    Right,
+    Count,
+};
+
+/* Output backend which shows up as a real controller, so the emulator gets the analog values instead
+ * of key presses. */
+class VirtualGamepad {
+public:
+    virtual ~VirtualGamepad() = default;
+
+    /* [-HID_JOYSTICK_MAX, HID_JOYSTICK_MAX], positive x is right and positive y is down */
+    virtual void SetStick(GamepadStick stick, int32_t x, int32_t y) = 0;
+    /* -1, 0 or 1 for each axis, same directions as the sticks */
+    virtual void SetDPad(int32_t x, int32_t y) = 0;
+    virtual void SetButton(GamepadButton button, bool pressed) = 0;
+    /* sends every change made since the last flush as a single report */
+    virtual void Flush() = 0;
+};
@@ -483,6 +483,32 @@ LRESULT WinNative::LowLevelMouseProc(int nCode, WPARAM wParam, LPARAM lParam) {
         case WM_MBUTTONUP:
             EventBus::Instance().publish(MouseButtonEvent(MOUSE_MBUTTON, false, x, y));
             break;
+        case WM_XBUTTONDOWN:
+        case WM_XBUTTONUP: {
+            const auto mouse_data = ((MSLLHOOKSTRUCT*)lParam)->mouseData;
+            const uint32_t button =
+                HIWORD(mouse_data) == XBUTTON1 ? MOUSE_XBUTTON1 : MOUSE_XBUTTON2;
+            EventBus::Instance().publish(
+                MouseButtonEvent(button, wParam == WM_XBUTTONDOWN, x, y));
+            break;
+        }
+        case WM_MOUSEWHEEL:
+        case WM_MOUSEHWHEEL: {
+            /* one press for every notch, smooth scrolling wheels add up to one first */
+            static int remainders[2]{};
+            const bool vertical = wParam == WM_MOUSEWHEEL;
+            int& remainder = remainders[vertical ? 0 : 1];
+            remainder += GET_WHEEL_DELTA_WPARAM(((MSLLHOOKSTRUCT*)lParam)->mouseData);
+            for (; remainder >= WHEEL_DELTA; remainder -= WHEEL_DELTA) {
+                EventBus::Instance().publish(MouseButtonEvent(
+                    vertical ? MOUSE_WHEEL_UP : MOUSE_WHEEL_RIGHT, true, x, y));
+            }
+            for (; remainder <= -WHEEL_DELTA; remainder += WHEEL_DELTA) {
+                EventBus::Instance().publish(MouseButtonEvent(
+                    vertical ? MOUSE_WHEEL_DOWN : MOUSE_WHEEL_LEFT, true, x, y));
+            }
+            break;
+        }
         }
     }
     return CallNextHookEx(nullptr, nCode, wParam, lParam);